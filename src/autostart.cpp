@@ -3,8 +3,19 @@
 #include <TlHelp32.h>
 #include "autostart.hpp"
 #include "config.hpp"
-#include <QString>
-#include <obs-module.h>
+#include "launch-job.hpp"
+#include "trace.hpp"
+#include "launch-registry.hpp"
+#include "output-capture.hpp"
+#include "launch-journal.hpp"
+#include "process-events.hpp"
+#include "supervisor.hpp"
+#include "integrity.hpp"
+#include "file-handlers.hpp"
+#include "status-page.hpp"
+#include "constants.hpp"
+#include "host.hpp"
+#include <QThreadPool>
 #include <algorithm>
 
 class ScopedHandle {
@@ -18,181 +29,834 @@ public:
     ScopedHandle& operator=(const ScopedHandle&) = delete;
 };
 
-std::vector<HANDLE> AutoStarter::launchedProcesses;
+/**
+ * @brief Returns the creation time of a process, or 0 if it is unknown.
+ */
+static uint64_t ProcessStartTime(HANDLE process)
+{
+	FILETIME creationTime, exitTime, kernelTime, userTime;
+	if (!GetProcessTimes(process, &creationTime, &exitTime, &kernelTime,
+			     &userTime))
+		return 0;
+	return ((uint64_t)creationTime.dwHighDateTime << 32) |
+	       creationTime.dwLowDateTime;
+}
+
+/**
+ * @brief Starts a compiled program from within the OBS process.
+ */
+static void SpawnInProcess(const std::string &loadoutName,
+			   const LaunchPlan &plan, HANDLE &process,
+			   unsigned long &processId, unsigned long &errorCode)
+{
+	STARTUPINFOEXW si = {{sizeof(STARTUPINFOW)}};
+	DWORD creationFlags =
+		plan.environment.empty() ? 0 : CREATE_UNICODE_ENVIRONMENT;
+
+	// check if the minimized flag is set
+	if (plan.minimized) {
+		si.StartupInfo.dwFlags = STARTF_USESHOWWINDOW; // Minimize the window
+		si.StartupInfo.wShowWindow = SW_SHOWMINIMIZED; // Minimize the window
+	}
+
+	// Hand the child only the capture pipe, no other inheritable handles
+	HANDLE outputHandle = nullptr;
+	std::unique_ptr<char[]> attributeBuffer;
+	if (plan.captureOutput &&
+	    OutputCapture::CreatePipe(loadoutName, plan.fullPath,
+				      plan.displayName, outputHandle)) {
+		SIZE_T attributeSize = 0;
+		InitializeProcThreadAttributeList(nullptr, 1, 0, &attributeSize);
+		attributeBuffer = std::make_unique<char[]>(attributeSize);
+		si.lpAttributeList =
+			(LPPROC_THREAD_ATTRIBUTE_LIST)attributeBuffer.get();
+		if (InitializeProcThreadAttributeList(
+			    si.lpAttributeList, 1, 0, &attributeSize) &&
+		    UpdateProcThreadAttribute(
+			    si.lpAttributeList, 0,
+			    PROC_THREAD_ATTRIBUTE_HANDLE_LIST, &outputHandle,
+			    sizeof(HANDLE), nullptr, nullptr)) {
+			si.StartupInfo.dwFlags |= STARTF_USESTDHANDLES;
+			si.StartupInfo.hStdOutput = outputHandle;
+			si.StartupInfo.hStdError = outputHandle;
+			si.StartupInfo.cb = sizeof(STARTUPINFOEXW);
+			creationFlags |= EXTENDED_STARTUPINFO_PRESENT;
+		} else {
+			si.lpAttributeList = nullptr;
+		}
+	}
+	bool inheritHandles = si.lpAttributeList != nullptr;
+	PROCESS_INFORMATION pi;
+
+	// CreateProcessW may write to the command line, the plan is shared.
+	// The buffer keeps its capacity, so later launches do not allocate.
+	thread_local std::vector<wchar_t> commandLine;
+	commandLine.assign(plan.commandLine.begin(), plan.commandLine.end());
+
+	BOOL created = CreateProcessW(
+		NULL,               // No module name (use command line)
+		commandLine.data(), // Copy of the prebuilt command line
+		NULL, // Process handle not inheritable
+		NULL, // Thread handle not inheritable
+		inheritHandles, // Inherit only the listed capture pipe
+		creationFlags,
+		plan.environment.empty()
+			? NULL
+			: (LPVOID)plan.environment.data(), // Prebuilt environment
+		plan.workingDirectory.empty()
+			? NULL
+			: plan.workingDirectory.c_str(), // Use provided path
+		&si.StartupInfo, // Pointer to STARTUPINFO structure
+		&pi); // Pointer to PROCESS_INFORMATION structure
+	if (created) {
+		CloseHandle(
+			pi.hThread); // Close thread handle as we don't need it
+		process = pi.hProcess;
+		processId = pi.dwProcessId;
+	} else {
+		errorCode = GetLastError();
+	}
+
+	// The child owns its copy of the pipe now
+	if (si.lpAttributeList)
+		DeleteProcThreadAttributeList(si.lpAttributeList);
+	if (outputHandle)
+		CloseHandle(outputHandle);
+}
+
+std::vector<LaunchedProcess> AutoStarter::launchedProcesses;
+std::mutex AutoStarter::processMutex;
+std::atomic<bool> AutoStarter::dryRun{false};
 
 /**
  * @brief Launch all programs defined in a specific loadout.
  */
 bool AutoStarter::LaunchPrograms(const std::string &loadoutName)
 {
-	auto &config = PluginConfig::Get();
-	std::string targetLoadout = loadoutName.empty() ? config.currentLoadout
+	TraceSpan span("LaunchPrograms", "launch", loadoutName.c_str());
+	auto config = PluginConfig::Get().Snapshot();
+	std::string targetLoadout = loadoutName.empty() ? config->currentLoadout
 							: loadoutName;
 
-	Loadout *loadout = config.GetLoadout(targetLoadout);
-	if (!loadout) {
-		blog(LOG_WARNING, "Loadout '%s' not found",
-		     targetLoadout.c_str());
+	auto plan = config->GetPlan(targetLoadout);
+	if (!plan) {
+		Host::Log(Host::Warning, "Loadout '%s' not found",
+			  targetLoadout.c_str());
 		return false;
 	}
 
+	// Reserve up front so tracking a new process never allocates
+	{
+		std::lock_guard<std::mutex> lock(processMutex);
+		launchedProcesses.reserve(launchedProcesses.size() +
+					  plan->programs.size());
+	}
+
 	bool success = true;
-	for (const auto &program : loadout->programs) {
-		if (!LaunchProgram(program)) {
-			blog(LOG_WARNING, "Failed to launch program: %s/%s",
-			     program.path.c_str(), program.executable.c_str());
+	for (size_t i = 0; i < plan->programs.size(); i++) {
+		unsigned long errorCode = 0;
+		if (!LaunchProgram(plan, i, errorCode)) {
+			Host::Log(Host::Warning,
+				  "Failed to launch program: %ls",
+				  plan->programs[i].fullPath.c_str());
 			success = false;
+			continue;
 		}
+		Trace::AddInstant("spawned", "launch",
+				  plan->programs[i].displayName.c_str());
 	}
 
 	return success;
 }
 
 /**
- * @brief Checks if any process with the given executable name is running.
+ * @brief Prepares a job that launches a loadout on a worker thread.
  */
-bool AutoStarter::IsProcessRunning(const std::string& executableName)
+LaunchJob *AutoStarter::LaunchProgramsAsync(const std::string &loadoutName)
 {
-    ScopedHandle snapshot(CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0));
-    if (snapshot.get() == INVALID_HANDLE_VALUE) {
-        return false;
-    }
+	auto config = PluginConfig::Get().Snapshot();
+	std::string targetLoadout = loadoutName.empty() ? config->currentLoadout
+							: loadoutName;
 
-    PROCESSENTRY32W pe32;
-    pe32.dwSize = sizeof(pe32);
+	auto plan = config->GetPlan(targetLoadout);
+	if (!plan) {
+		Host::Log(Host::Warning, "Loadout '%s' not found",
+			  targetLoadout.c_str());
+		return nullptr;
+	}
 
-    if (!Process32FirstW(snapshot.get(), &pe32)) {
-        return false;
-    }
+	{
+		std::lock_guard<std::mutex> lock(processMutex);
+		launchedProcesses.reserve(launchedProcesses.size() +
+					  plan->programs.size());
+	}
 
-    std::wstring searchName = QString::fromStdString(executableName).toStdWString();
-    // Convert to lowercase for case-insensitive comparison
-    std::transform(searchName.begin(), searchName.end(), searchName.begin(), ::tolower);
+	return new LaunchJob(std::move(plan));
+}
 
-    do {
-        std::wstring processName = pe32.szExeFile;
-        std::transform(processName.begin(), processName.end(), processName.begin(), ::tolower);
-        
-        if (processName == searchName) {
-            return true;
-        }
-    } while (Process32NextW(snapshot.get(), &pe32));
+/**
+ * @brief Checks if any process with the given executable name is running.
+ */
+bool AutoStarter::IsProcessRunning(const std::wstring &imageName)
+{
+	TraceSpan span("IsProcessRunning", "snapshot");
+	ScopedHandle snapshot(CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0));
+	if (snapshot.get() == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	PROCESSENTRY32W pe32;
+	pe32.dwSize = sizeof(pe32);
+
+	if (!Process32FirstW(snapshot.get(), &pe32)) {
+		return false;
+	}
 
-    return false;
+	do {
+		// Case-insensitive comparison without temporary copies
+		if (_wcsicmp(pe32.szExeFile, imageName.c_str()) == 0) {
+			return true;
+		}
+	} while (Process32NextW(snapshot.get(), &pe32));
+
+	return false;
 }
 
 /**
  * @brief Attempts to launch a single program, either as .exe or via ShellExecute for other file types.
  */
-bool AutoStarter::LaunchProgram(const Program &program)
+bool AutoStarter::LaunchProgram(
+	const std::shared_ptr<const LoadoutPlan> &loadout, size_t index,
+	unsigned long &errorCode)
 {
-    // Check if program is already running
-    if (IsProcessRunning(program.executable)) {
-        blog(LOG_INFO, "Program '%s' is already running, skipping launch",
-             program.executable.c_str());
-        return true;
-    }
+	uint64_t launchStartNs = Trace::Now();
+	// Commands on the PATH may have moved since the plan was compiled
+	LaunchPlan relocated;
+	const LaunchPlan &plan =
+		RelocateCommand(loadout->programs[index], relocated)
+			? relocated
+			: loadout->programs[index];
+
+	if (dryRun) {
+		Host::Log(Host::Info, "Dry run, not launching '%s': %ls",
+			  plan.displayName.c_str(), plan.fullPath.c_str());
+		return true;
+	}
 
-	QString fullPath =
-		QString::fromStdString(program.path + "/" + program.executable);
+	// Never run a pinned program that was replaced on disk. The file stays
+	// locked until this call returns, so it cannot be swapped between the
+	// check and the spawn, also when the supervisor spawns it.
+	std::string digest;
+	HANDLE pin = INVALID_HANDLE_VALUE;
+	bool verified = plan.sha256.empty() ||
+			Integrity::VerifyPinned(plan.fullPath, plan.sha256,
+						digest, pin);
+	ScopedHandle pinnedFile(pin);
+	if (!verified) {
+		errorCode = ERROR_INVALID_IMAGE_HASH;
+		Host::Log(Host::Warning,
+			  "Refusing to launch '%s', its SHA-256 is %s instead of the pinned %s",
+			  plan.displayName.c_str(),
+			  digest.empty() ? "unreadable" : digest.c_str(),
+			  plan.sha256.c_str());
+		Host::ProgramFailed(loadout->name.c_str(), index,
+				    plan.displayName.c_str(), errorCode);
+		return false;
+	}
+
+	// A program another loadout already tracks is shared within OBS
+	if (plan.method == LaunchMethod::Spawn &&
+	    ShareTracked(loadout, index, plan.fullPath))
+		return true;
+
+	// Share executables with other OBS instances of this session
+	int registryEntry = -1;
+	if (plan.method == LaunchMethod::Spawn) {
+		unsigned long sharedProcessId = 0;
+		switch (LaunchRegistry::Acquire(plan.fullPath, registryEntry,
+						sharedProcessId)) {
+		case LaunchRegistry::Acquisition::Adopt:
+			if (AdoptProcess(loadout, index, plan.fullPath,
+					 sharedProcessId, registryEntry))
+				return true;
+			registryEntry = -1;
+			break;
+		case LaunchRegistry::Acquisition::Spawn:
+		case LaunchRegistry::Acquisition::Unavailable:
+			break;
+		}
+	}
 
-	// Check if the program is a exe or a file to open
-	std::string extension;
-	size_t dotPos = program.executable.find_last_of('.');
-	if (dotPos != std::string::npos) {
-		extension = program.executable.substr(dotPos);
+	// Check if program is already running
+	if (IsProcessRunning(plan.imageName)) {
+		Host::Log(Host::Info,
+			  "Program '%s' is already running, skipping launch",
+			  plan.displayName.c_str());
+		// Not started by any instance, so nobody shares it
+		LaunchRegistry::CancelSpawn(registryEntry);
+		LaunchRegistry::Release(registryEntry);
+		return true;
 	}
 
-	if (!extension.empty() && extension != ".exe") {
-		// For non-exe files, use ShellExecute
-		HINSTANCE result = ShellExecuteA(NULL, "open",
-						 fullPath.toStdString().c_str(),
-						 NULL, program.path.c_str(),
-						 SW_SHOWNORMAL);
+	TraceSpan span("spawn", "launch", plan.displayName.c_str());
+
+	if (plan.method == LaunchMethod::ShellOpen) {
+		// Start the registered handler directly, a single spawn per file
+		std::vector<wchar_t> handlerCommand;
+		if (FileHandlers::CommandLine(plan.fullPath, plan.parameters,
+					      handlerCommand)) {
+			STARTUPINFOW si = {sizeof(si)};
+			PROCESS_INFORMATION pi;
+			if (CreateProcessW(NULL, handlerCommand.data(), NULL,
+					   NULL, FALSE, 0, NULL,
+					   plan.workingDirectory.empty()
+						   ? NULL
+						   : plan.workingDirectory.c_str(),
+					   &si, &pi)) {
+				// Documents are not tracked, like with the shell
+				CloseHandle(pi.hThread);
+				CloseHandle(pi.hProcess);
+				Host::Log(Host::Info,
+					  "Successfully opened file: %s",
+					  plan.displayName.c_str());
+				Host::ProgramLaunched(
+					loadout->name.c_str(), index,
+					plan.displayName.c_str(),
+					pi.dwProcessId);
+				return true;
+			}
+			Host::Log(Host::Info,
+				  "Handler of '%s' failed to start, error code: %lu, using the shell",
+				  plan.displayName.c_str(), GetLastError());
+		}
+
+		// Fall back to ShellExecute for handlers without a command
+		HINSTANCE result = ShellExecuteW(
+			NULL, L"open", plan.fullPath.c_str(),
+			plan.parameters.empty() ? NULL
+						: plan.parameters.c_str(),
+			plan.workingDirectory.empty()
+				? NULL
+				: plan.workingDirectory.c_str(),
+			SW_SHOWNORMAL);
 		if ((intptr_t)result > 32) {
-			blog(LOG_INFO, "Successfully opened file: %s",
-			     program.executable.c_str());
+			Host::Log(Host::Info, "Successfully opened file: %s",
+				  plan.displayName.c_str());
+			// The handler process is not known
+			Host::ProgramLaunched(loadout->name.c_str(), index,
+					      plan.displayName.c_str(), 0);
 			return true;
 		}
-		blog(LOG_WARNING, "Failed to open file '%s', error code: %d",
-		     program.executable.c_str(), (intptr_t)result);
+		errorCode = (unsigned long)(intptr_t)result;
+		Host::Log(Host::Warning,
+			  "Failed to open file '%s', error code: %lu",
+			  plan.displayName.c_str(), errorCode);
+		Host::ProgramFailed(loadout->name.c_str(), index,
+				    plan.displayName.c_str(), errorCode);
 		return false;
 	}
 
-    STARTUPINFO si = {sizeof(STARTUPINFO)};
-
-    // check if the minimized flag is set
-    if (program.minimized) {
-        si.dwFlags = STARTF_USESHOWWINDOW;  // Minimize the window
-        si.wShowWindow = SW_SHOWMINIMIZED;  // Minimize the window
-    }
-    PROCESS_INFORMATION pi;
-
-	std::wstring commandLine = fullPath.toStdWString();
-
-	if (CreateProcess(NULL, // No module name (use command line)
-			  (LPWSTR)commandLine.c_str(), // Command line
-			  NULL,  // Process handle not inheritable
-			  NULL,  // Thread handle not inheritable
-			  FALSE, // Set handle inheritance to FALSE
-			  0,     // No creation flags
-			  NULL,  // Use parent's environment block
-			  (LPCWSTR)QString::fromStdString(program.path)
-				  .toStdWString()
-				  .c_str(), // Use provided path
-			  &si,              // Pointer to STARTUPINFO structure
-			  &pi) // Pointer to PROCESS_INFORMATION structure
-	) {
-		CloseHandle(
-			pi.hThread); // Close thread handle as we don't need it
-		launchedProcesses.push_back(
-			pi.hProcess); // Store process handle
-		blog(LOG_INFO, "Successfully launched: %s (handle: %p)",
-		     program.executable.c_str(), pi.hProcess);
+	// The supervisor spawns whatever does not need OBS handles, so the
+	// program stays guarded if OBS goes down
+	HANDLE process = nullptr;
+	unsigned long processId = 0;
+	if (plan.captureOutput ||
+	    !Supervisor::Spawn(plan, process, processId, errorCode)) {
+		SpawnInProcess(loadout->name, plan, process, processId,
+			       errorCode);
+		// Programs with pipes into OBS are guarded by the helper too
+		if (process)
+			Supervisor::Adopt(processId);
+	}
+	bool created = process != nullptr;
+
+	if (created) {
+		LaunchRegistry::Publish(registryEntry, processId);
+		// Recorded from the shared plan unless the command moved
+		if (&plan == &relocated)
+			LaunchJournal::Record({processId,
+					       ProcessStartTime(process),
+					       plan.fullPath, loadout->name});
+		else
+			LaunchJournal::Record(processId,
+					      ProcessStartTime(process),
+					      loadout, index);
+		{
+			std::lock_guard<std::mutex> lock(processMutex);
+			launchedProcesses.push_back(
+				{process, loadout, index, false, registryEntry,
+				 ProcessEvents::Get().Watch(
+					 process, loadout->name, index,
+					 plan.fullPath),
+				 plan.fullPath}); // Store process handle
+		}
+		Host::Log(Host::Info, "Successfully launched: %s (handle: %p)",
+			  plan.displayName.c_str(), process);
+		StatusPage::Launched(loadout->name, plan.displayName, processId,
+				     Trace::Now() - launchStartNs);
+		Host::ProgramLaunched(loadout->name.c_str(), index,
+				      plan.displayName.c_str(), processId);
 		return true;
 	}
 
-	blog(LOG_WARNING, "Failed to launch process '%s', error code: %d",
-	     program.executable.c_str(), GetLastError());
+	LaunchRegistry::CancelSpawn(registryEntry);
+	LaunchRegistry::Release(registryEntry);
+	Host::Log(Host::Warning,
+		  "Failed to launch process '%s', error code: %lu",
+		  plan.displayName.c_str(), errorCode);
+	Host::ProgramFailed(loadout->name.c_str(), index,
+			    plan.displayName.c_str(), errorCode);
 	return false;
 }
 
+/**
+ * @brief Waits for the tracked process of a plan entry to go idle.
+ */
+AutoStarter::Readiness AutoStarter::WaitUntilReady(
+	const std::shared_ptr<const LoadoutPlan> &loadout, size_t index,
+	unsigned long timeoutMs, const std::atomic<bool> &cancelled)
+{
+	// Wait on a copy of the handle, never while holding the lock
+	HANDLE process = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(processMutex);
+		for (const auto &launched : launchedProcesses) {
+			if (launched.loadout != loadout ||
+			    launched.index != index)
+				continue;
+			// Adopted programs are up already, there is no launch
+			// to wait for or to time
+			if (launched.adopted)
+				break;
+			DuplicateHandle(GetCurrentProcess(), launched.handle,
+					GetCurrentProcess(), &process, 0,
+					FALSE, DUPLICATE_SAME_ACCESS);
+			break;
+		}
+	}
+	if (!process)
+		return Readiness::Untracked;
+
+	// WaitForInputIdle cannot wait on an event, so wait in slices to
+	// notice a cancellation. Programs without a message loop fail right
+	// away and count as ready.
+	DWORD result = WAIT_TIMEOUT;
+	for (unsigned long waited = 0; waited < timeoutMs && !cancelled;
+	     waited += Constants::READY_POLL_MS) {
+		unsigned long slice = timeoutMs - waited;
+		if (slice > Constants::READY_POLL_MS)
+			slice = Constants::READY_POLL_MS;
+		result = WaitForInputIdle(process, slice);
+		if (result != WAIT_TIMEOUT)
+			break;
+	}
+	CloseHandle(process);
+
+	if (result != WAIT_TIMEOUT)
+		return Readiness::Ready;
+	return cancelled ? Readiness::Cancelled : Readiness::TimedOut;
+}
+
+/**
+ * @brief Tracks a program that another OBS instance already launched.
+ */
+bool AutoStarter::AdoptProcess(const std::shared_ptr<const LoadoutPlan> &loadout,
+			       size_t index, const std::wstring &path,
+			       unsigned long processId, int registryEntry)
+{
+	HANDLE process = OpenProcess(PROCESS_TERMINATE | SYNCHRONIZE |
+					     PROCESS_QUERY_INFORMATION |
+					     PROCESS_VM_READ |
+					     PROCESS_SUSPEND_RESUME,
+				     FALSE, processId);
+	if (!process) {
+		LaunchRegistry::Release(registryEntry);
+		return false;
+	}
+
+	// The helper quits it only if no other instance uses it by then
+	Supervisor::Adopt(processId);
+
+	std::lock_guard<std::mutex> lock(processMutex);
+	launchedProcesses.push_back(
+		{process, loadout, index, false, registryEntry,
+		 ProcessEvents::Get().Watch(process, loadout->name, index, path),
+		 path, true});
+	Host::Log(Host::Info,
+		  "Sharing '%s' (PID %lu) with another OBS instance",
+		  loadout->programs[index].displayName.c_str(), processId);
+	StatusPage::Tracked(loadout->name, loadout->programs[index].displayName,
+			    processId);
+	return true;
+}
+
+/**
+ * @brief Tracks a program of this instance for one more loadout.
+ */
+bool AutoStarter::ShareTracked(const std::shared_ptr<const LoadoutPlan> &loadout,
+			       size_t index, const std::wstring &path)
+{
+	HANDLE process = nullptr;
+	int registryEntry = -1;
+	bool frozen = false;
+	{
+		std::lock_guard<std::mutex> lock(processMutex);
+		const LaunchedProcess *tracked = nullptr;
+		for (const auto &launched : launchedProcesses) {
+			if (_wcsicmp(launched.path.c_str(), path.c_str()) != 0 ||
+			    WaitForSingleObject(launched.handle, 0) !=
+				    WAIT_TIMEOUT)
+				continue;
+			// Launched again while it still runs
+			if (launched.loadout == loadout &&
+			    launched.index == index)
+				return true;
+			tracked = tracked ? tracked : &launched;
+		}
+		if (!tracked)
+			return false;
+
+		// Uses are only counted for shared programs, an unshared one
+		// stays with the loadout that launched it
+		if (tracked->registryEntry < 0)
+			return true;
+		if (!DuplicateHandle(GetCurrentProcess(), tracked->handle,
+				     GetCurrentProcess(), &process, 0, FALSE,
+				     DUPLICATE_SAME_ACCESS))
+			return true;
+		registryEntry = tracked->registryEntry;
+		frozen = tracked->frozen;
+		LaunchRegistry::Retain(registryEntry);
+	}
+
+	ProcessWatch *watch =
+		ProcessEvents::Get().Watch(process, loadout->name, index, path);
+	{
+		std::lock_guard<std::mutex> lock(processMutex);
+		launchedProcesses.push_back({process, loadout, index, frozen,
+					     registryEntry, watch, path, true});
+	}
+	Host::Log(Host::Info, "'%s' (PID %lu) is shared with another loadout",
+		  loadout->programs[index].displayName.c_str(),
+		  GetProcessId(process));
+	return true;
+}
+
+/**
+ * @brief Diffs the tracked programs against a loadout and prepares the launch of the missing ones.
+ */
+LaunchJob *AutoStarter::SwitchLoadout(const std::string &loadoutName)
+{
+	auto plan = PluginConfig::Get().GetPlan(loadoutName);
+	if (!plan) {
+		Host::Log(Host::Warning, "Loadout '%s' not found",
+			  loadoutName.c_str());
+		return nullptr;
+	}
+
+	auto job = new LaunchJob(plan);
+	std::vector<LaunchedProcess> leaving;
+	// Kept programs that change loadout or thaw, they leave the list while
+	// their watch, journal record and status are updated without the lock
+	std::vector<LaunchedProcess> moving;
+	size_t kept = 0;
+	{
+		std::lock_guard<std::mutex> lock(processMutex);
+		std::vector<LaunchedProcess> staying;
+		staying.reserve(launchedProcesses.size() +
+				plan->programs.size());
+
+		auto config = PluginConfig::Get().Snapshot();
+		std::vector<bool> covered(plan->programs.size(), false);
+		for (auto &process : launchedProcesses) {
+			// Programs of output triggers follow their output
+			const Loadout *source =
+				config->GetLoadout(process.loadout->name);
+			// Exited programs are pruned and launched again
+			if ((source &&
+			     source->trigger != LaunchTrigger::Startup) ||
+			    WaitForSingleObject(process.handle, 0) !=
+				    WAIT_TIMEOUT) {
+				staying.push_back(std::move(process));
+				continue;
+			}
+
+			// Match by the program the process was launched for,
+			// its own path may have been relocated since
+			const std::wstring &launchedFor =
+				process.loadout->programs[process.index]
+					.fullPath;
+			size_t target = 0;
+			for (; target < plan->programs.size(); target++) {
+				const std::wstring &path =
+					plan->programs[target].fullPath;
+				if (!covered[target] &&
+				    (_wcsicmp(path.c_str(),
+					      launchedFor.c_str()) == 0 ||
+				     _wcsicmp(path.c_str(),
+					      process.path.c_str()) == 0))
+					break;
+			}
+			if (target == plan->programs.size()) {
+				leaving.push_back(std::move(process));
+				continue;
+			}
+
+			covered[target] = true;
+			job->markRunning((int)target);
+			kept++;
+			if (process.frozen || process.loadout != plan ||
+			    process.index != target) {
+				// Track it under the target loadout from now on
+				process.loadout = plan;
+				process.index = target;
+				moving.push_back(std::move(process));
+			} else {
+				staying.push_back(std::move(process));
+			}
+		}
+		launchedProcesses.swap(staying);
+	}
+
+	for (auto &process : moving) {
+		if (process.frozen &&
+		    SetProcessFrozen(process.handle, false)) {
+			process.frozen = false;
+			StatusPage::SetFrozen(GetProcessId(process.handle),
+					      false);
+		}
+		ProcessEvents::Get().Unwatch(process.watch);
+		process.watch = ProcessEvents::Get().Watch(
+			process.handle, plan->name, process.index,
+			process.path);
+		DWORD processId = GetProcessId(process.handle);
+		LaunchJournal::Record({processId,
+				       ProcessStartTime(process.handle),
+				       process.path, plan->name});
+		StatusPage::Tracked(plan->name,
+				    plan->programs[process.index].displayName,
+				    processId);
+	}
+	if (!moving.empty()) {
+		std::lock_guard<std::mutex> lock(processMutex);
+		for (auto &process : moving)
+			launchedProcesses.push_back(std::move(process));
+	}
+
+	Host::Log(Host::Info,
+		  "Switching to loadout '%s': keeping %zu, quitting %zu, launching %zu programs",
+		  loadoutName.c_str(), kept, leaving.size(),
+		  plan->programs.size() - kept);
+
+	// Quit the leaving programs while the job launches the missing ones
+	for (const auto &process : leaving) {
+		QThreadPool::globalInstance()->start(
+			[process]() { QuitProcess(process); });
+	}
+	return job;
+}
+
+void AutoStarter::SetDryRun(bool enabled)
+{
+	dryRun = enabled;
+}
+
+bool AutoStarter::IsDryRun()
+{
+	return dryRun;
+}
+
 /**
  * @brief Quits all programs previously launched by AutoStarter.
  */
 bool AutoStarter::QuitPrograms()
 {
-	bool success = true;
+	// Quit outside the lock, Unwatch() waits for exit notifications
+	std::vector<LaunchedProcess> quitting;
+	{
+		std::lock_guard<std::mutex> lock(processMutex);
+		quitting.swap(launchedProcesses);
+	}
 
-	for (HANDLE process : launchedProcesses) {
+	bool success = true;
+	for (const auto &process : quitting) {
 		if (!QuitProcess(process)) {
 			success = false;
 		}
 	}
+	return success;
+}
+
+/**
+ * @brief Quits the programs that were launched from a specific loadout.
+ */
+bool AutoStarter::QuitLoadout(const std::string &loadoutName)
+{
+	std::vector<LaunchedProcess> quitting;
+	{
+		std::lock_guard<std::mutex> lock(processMutex);
+		auto it = std::stable_partition(
+			launchedProcesses.begin(), launchedProcesses.end(),
+			[&](const LaunchedProcess &process) {
+				return process.loadout->name != loadoutName;
+			});
+		quitting.assign(it, launchedProcesses.end());
+		launchedProcesses.erase(it, launchedProcesses.end());
+	}
 
-	ClearProcesses();
+	bool success = true;
+	for (const auto &process : quitting) {
+		if (!QuitProcess(process))
+			success = false;
+	}
 	return success;
 }
 
 /**
  * @brief Terminates a specific process handle.
  */
-bool AutoStarter::QuitProcess(HANDLE process)
+bool AutoStarter::QuitProcess(const LaunchedProcess &launched)
 {
+	HANDLE process = launched.handle;
 	if (process == NULL || process == INVALID_HANDLE_VALUE)
 		return false;
 
-	// First try to close gracefully
-	if (TerminateProcess(process, 0)) {
+	ProcessEvents::Get().Unwatch(launched.watch);
+	auto termination = LaunchRegistry::BeginTerminate(launched.registryEntry);
+
+	// Another loadout still tracks it, its journal and status entries stay
+	if (termination == LaunchRegistry::Termination::UsedHere) {
 		CloseHandle(process);
 		return true;
 	}
 
-	blog(LOG_WARNING,
-	     "Failed to terminate process (handle: %p), error code: %d",
-	     process, GetLastError());
+	LaunchJournal::Remove(GetProcessId(process));
+	StatusPage::Stopped(GetProcessId(process));
+
+	// Keep programs alive that another OBS instance still uses
+	if (termination == LaunchRegistry::Termination::UsedElsewhere) {
+		Host::Log(Host::Info,
+			  "'%s' is still used by another OBS instance",
+			  launched.loadout->programs[launched.index]
+				  .displayName.c_str());
+		Supervisor::Release(GetProcessId(process));
+		CloseHandle(process);
+		return true;
+	}
+
+	// Programs the supervisor spawned are quit by it
+	bool terminated = Supervisor::Quit(GetProcessId(process)) ||
+			  TerminateProcess(process, 0);
+	if (!terminated)
+		Host::Log(Host::Warning,
+			  "Failed to terminate process (handle: %p), error code: %d",
+			  process, GetLastError());
+	LaunchRegistry::EndTerminate(launched.registryEntry);
 	CloseHandle(process);
-	return false;
+	return terminated;
+}
+
+/**
+ * @brief Freezes or thaws the programs that were launched from a specific loadout.
+ */
+bool AutoStarter::SetLoadoutFrozen(const std::string &loadoutName, bool frozen)
+{
+	std::lock_guard<std::mutex> lock(processMutex);
+	bool success = true;
+
+	for (auto &process : launchedProcesses) {
+		if (process.loadout->name != loadoutName ||
+		    process.frozen == frozen)
+			continue;
+
+		if (SetProcessFrozen(process.handle, frozen)) {
+			process.frozen = frozen;
+			StatusPage::SetFrozen(GetProcessId(process.handle),
+					      frozen);
+		} else {
+			success = false;
+		}
+	}
+
+	Host::Log(Host::Info, "%s loadout '%s'", frozen ? "Froze" : "Thawed",
+		  loadoutName.c_str());
+	return success;
+}
+
+bool AutoStarter::IsLoadoutFrozen(const std::string &loadoutName)
+{
+	std::lock_guard<std::mutex> lock(processMutex);
+	return std::any_of(launchedProcesses.begin(), launchedProcesses.end(),
+			   [&](const LaunchedProcess &process) {
+				   return process.frozen &&
+					  process.loadout->name == loadoutName;
+			   });
+}
+
+bool AutoStarter::IsLoadoutLaunched(const std::string &loadoutName)
+{
+	std::lock_guard<std::mutex> lock(processMutex);
+	return std::any_of(launchedProcesses.begin(), launchedProcesses.end(),
+			   [&](const LaunchedProcess &process) {
+				   return process.loadout->name == loadoutName;
+			   });
+}
+
+void AutoStarter::ForEachProcess(
+	const std::function<void(const LaunchedProcess &)> &visit)
+{
+	std::lock_guard<std::mutex> lock(processMutex);
+	for (const auto &process : launchedProcesses)
+		visit(process);
+}
+
+/**
+ * @brief Suspends or resumes a process, preferring the native whole-process call.
+ */
+bool AutoStarter::SetProcessFrozen(HANDLE process, bool frozen)
+{
+	using NtProcessFunc = LONG(WINAPI *)(HANDLE);
+	static const auto ntSuspendProcess = (NtProcessFunc)GetProcAddress(
+		GetModuleHandleW(L"ntdll.dll"), "NtSuspendProcess");
+	static const auto ntResumeProcess = (NtProcessFunc)GetProcAddress(
+		GetModuleHandleW(L"ntdll.dll"), "NtResumeProcess");
+
+	NtProcessFunc ntFunc = frozen ? ntSuspendProcess : ntResumeProcess;
+	if (ntFunc && ntFunc(process) >= 0)
+		return true;
+
+	// Fall back to suspending each thread of the process individually
+	DWORD processId = GetProcessId(process);
+	ScopedHandle snapshot(CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0));
+	if (processId == 0 || snapshot.get() == INVALID_HANDLE_VALUE) {
+		Host::Log(Host::Warning,
+			  "Failed to %s process (handle: %p), error code: %lu",
+			  frozen ? "freeze" : "thaw", process, GetLastError());
+		return false;
+	}
+
+	THREADENTRY32 te32;
+	te32.dwSize = sizeof(te32);
+	bool success = true;
+	if (Thread32First(snapshot.get(), &te32)) {
+		do {
+			if (te32.th32OwnerProcessID != processId)
+				continue;
+
+			HANDLE thread = OpenThread(THREAD_SUSPEND_RESUME, FALSE,
+						   te32.th32ThreadID);
+			if (!thread) {
+				success = false;
+				continue;
+			}
+			DWORD result = frozen ? SuspendThread(thread)
+					      : ResumeThread(thread);
+			if (result == (DWORD)-1)
+				success = false;
+			CloseHandle(thread);
+		} while (Thread32Next(snapshot.get(), &te32));
+	}
+	return success;
 }
 
 /**
@@ -200,10 +864,159 @@ bool AutoStarter::QuitProcess(HANDLE process)
  */
 void AutoStarter::ClearProcesses()
 {
-	for (HANDLE process : launchedProcesses) {
-		if (process != NULL && process != INVALID_HANDLE_VALUE) {
+	std::vector<LaunchedProcess> clearing;
+	{
+		std::lock_guard<std::mutex> lock(processMutex);
+		clearing.swap(launchedProcesses);
+	}
+
+	for (const auto &process : clearing) {
+		LaunchRegistry::Release(process.registryEntry);
+		ProcessEvents::Get().Unwatch(process.watch);
+		if (process.handle != NULL &&
+		    process.handle != INVALID_HANDLE_VALUE) {
+			Supervisor::Release(GetProcessId(process.handle));
+			CloseHandle(process.handle);
+		}
+	}
+
+	// The programs were handed over on purpose, nothing to recover
+	LaunchJournal::Clear();
+}
+
+/**
+ * @brief Drops the processes that exited from the tracked ones.
+ */
+void AutoStarter::PruneExited()
+{
+	std::vector<LaunchedProcess> exited;
+	{
+		std::lock_guard<std::mutex> lock(processMutex);
+		auto it = std::stable_partition(
+			launchedProcesses.begin(), launchedProcesses.end(),
+			[](const LaunchedProcess &process) {
+				return WaitForSingleObject(process.handle, 0) !=
+				       WAIT_OBJECT_0;
+			});
+		exited.assign(it, launchedProcesses.end());
+		launchedProcesses.erase(it, launchedProcesses.end());
+	}
+
+	for (const auto &process : exited) {
+		DWORD processId = GetProcessId(process.handle);
+		ProcessEvents::Get().Unwatch(process.watch);
+		LaunchJournal::Remove(processId);
+		Supervisor::Release(processId);
+		// The last user frees the registry entry for a new spawn
+		if (LaunchRegistry::BeginTerminate(process.registryEntry) ==
+		    LaunchRegistry::Termination::Terminate)
+			LaunchRegistry::EndTerminate(process.registryEntry);
+		CloseHandle(process.handle);
+	}
+}
+
+/**
+ * @brief Re-adopts or quits the programs recorded by a crashed session.
+ */
+void AutoStarter::RecoverProcesses(bool quit)
+{
+	std::vector<LaunchJournal::Entry> entries = LaunchJournal::Load();
+	if (entries.empty())
+		return;
+
+	// Recovered programs are recorded again under this instance
+	for (const auto &entry : entries)
+		LaunchJournal::Remove(entry.processId);
+
+	auto config = PluginConfig::Get().Snapshot();
+	for (const auto &entry : entries) {
+		HANDLE process = OpenProcess(PROCESS_TERMINATE | SYNCHRONIZE |
+						     PROCESS_QUERY_INFORMATION |
+						     PROCESS_VM_READ |
+						     PROCESS_SUSPEND_RESUME,
+					     FALSE, entry.processId);
+		if (!process)
+			continue;
+
+		// The start time and image path tell a reused ID apart
+		wchar_t imagePath[MAX_PATH];
+		DWORD imagePathSize = MAX_PATH;
+		DWORD exitCode = 0;
+		if (ProcessStartTime(process) != entry.startTime ||
+		    !GetExitCodeProcess(process, &exitCode) ||
+		    exitCode != STILL_ACTIVE ||
+		    !QueryFullProcessImageNameW(process, 0, imagePath,
+						&imagePathSize) ||
+		    _wcsicmp(imagePath, entry.path.c_str()) != 0) {
+			CloseHandle(process);
+			continue;
+		}
+
+		// Programs another running instance shares are never quit here.
+		// Runs during load, so never wait for other instances.
+		int registryEntry = -1;
+		unsigned long sharedProcessId = 0;
+		auto acquisition = LaunchRegistry::TryAcquire(
+			entry.path, registryEntry, sharedProcessId);
+		if (acquisition == LaunchRegistry::Acquisition::Spawn)
+			LaunchRegistry::Publish(registryEntry, entry.processId);
+		bool shared = acquisition ==
+			      LaunchRegistry::Acquisition::Adopt;
+
+		auto plan = config->GetPlan(entry.loadout);
+		size_t index = 0;
+		bool found = false;
+		for (; plan && index < plan->programs.size(); index++) {
+			if (_wcsicmp(plan->programs[index].fullPath.c_str(),
+				     entry.path.c_str()) == 0) {
+				found = true;
+				break;
+			}
+		}
+
+		if ((quit && !shared) || !found) {
+			if (quit && !shared) {
+				Host::Log(Host::Info,
+					  "Quitting '%ls' (PID %lu) left over from a previous session",
+					  entry.path.c_str(), entry.processId);
+				if (LaunchRegistry::BeginTerminate(
+					    registryEntry) ==
+				    LaunchRegistry::Termination::Terminate) {
+					TerminateProcess(process, 0);
+					LaunchRegistry::EndTerminate(
+						registryEntry);
+				}
+				registryEntry = -1;
+			} else {
+				Host::Log(Host::Info,
+					  "Leaving '%ls' (PID %lu) running, loadout '%s' no longer contains it",
+					  entry.path.c_str(), entry.processId,
+					  entry.loadout.c_str());
+			}
+			LaunchRegistry::Release(registryEntry);
 			CloseHandle(process);
+			continue;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(processMutex);
+			launchedProcesses.push_back(
+				{process, plan, index, false, registryEntry,
+				 ProcessEvents::Get().Watch(process,
+							    plan->name, index,
+							    entry.path),
+				 entry.path, true});
 		}
+		LaunchJournal::Record(entry);
+		StatusPage::Tracked(plan->name,
+				    plan->programs[index].displayName,
+				    entry.processId);
+		// Guard it like the programs launched in this session
+		if (!shared)
+			Supervisor::Adopt(entry.processId);
+		Host::Log(Host::Info,
+			  "Recovered '%ls' (PID %lu) of loadout '%s' from a previous session",
+			  entry.path.c_str(), entry.processId,
+			  entry.loadout.c_str());
 	}
-	launchedProcesses.clear();
 }
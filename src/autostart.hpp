@@ -1,11 +1,32 @@
 #pragma once
+#include <atomic>
+#include <functional>
+#include <mutex>
 #include <vector>
 #include <string>
 #include "config.hpp"
+#include "launch-plan.hpp"
 
 // Forward declare Windows types
 using HANDLE = void*;
 
+class LaunchJob;
+struct ProcessWatch;
+
+/**
+ * @brief A process launched by AutoStarter together with its origin.
+ */
+struct LaunchedProcess {
+    HANDLE handle;                              ///< Windows process handle
+    std::shared_ptr<const LoadoutPlan> loadout; ///< Plan the process was launched from
+    size_t index;                               ///< Index of the program within the plan
+    bool frozen = false;                        ///< Whether the process is currently suspended
+    int registryEntry = -1;                     ///< Shared launch registry entry, -1 if not shared
+    ProcessWatch *watch = nullptr;              ///< Exit notification, see ProcessEvents
+    std::wstring path;                          ///< Resolved path the process was started from
+    bool adopted = false;                       ///< Started by another instance or an earlier session
+};
+
 /**
  * @brief Manages launch and termination of external processes.
  */
@@ -18,38 +39,180 @@ public:
      */
     static bool LaunchPrograms(const std::string &loadoutName = "");
 
+    /**
+     * @brief Launch all programs from the provided loadout without blocking.
+     * @param loadoutName The name of the loadout to launch. If empty, uses the current plug-in loadout.
+     * @return The job, or nullptr if the loadout does not exist. Connect to its signals, then call start(); it deletes itself once finished.
+     */
+    static LaunchJob *LaunchProgramsAsync(const std::string &loadoutName = "");
+
+    /**
+     * @brief Switch to a loadout, keeping the programs it shares with the running set.
+     *
+     * Tracked programs are matched against the target loadout by the path of the
+     * program they were launched for, or the path they were started from.
+     * Matches keep running and are moved to the target loadout, all other tracked
+     * programs are quit in the background while the missing ones are launched.
+     * Programs of output-triggered loadouts are left alone, and programs that
+     * already exited never count as a match.
+     * @param loadoutName The name of the loadout to switch to.
+     * @return The job that launches the missing programs, or nullptr if the loadout does not exist. Connect to its signals, then call start().
+     */
+    static LaunchJob *SwitchLoadout(const std::string &loadoutName);
+
     /**
      * @brief Terminate all previously launched processes.
      * @return true on success, false if any process failed to quit.
      */
     static bool QuitPrograms();
 
+    /**
+     * @brief Terminate the processes that were launched from a specific loadout.
+     * @param loadoutName The name of the loadout whose processes should quit.
+     * @return true on success, false if any process failed to quit.
+     */
+    static bool QuitLoadout(const std::string &loadoutName);
+
+    /**
+     * @brief Suspend or resume the processes that were launched from a specific loadout.
+     * @param loadoutName The name of the loadout whose processes should be frozen or thawed.
+     * @param frozen true to suspend the processes, false to resume them.
+     * @return true on success, false if any process could not be changed.
+     */
+    static bool SetLoadoutFrozen(const std::string &loadoutName, bool frozen);
+
+    /**
+     * @brief Check whether the processes of a loadout are currently suspended.
+     * @param loadoutName The name of the loadout.
+     * @return true if at least one tracked process of the loadout is frozen.
+     */
+    static bool IsLoadoutFrozen(const std::string &loadoutName);
+
+    /**
+     * @brief Check whether any processes launched from a loadout are tracked.
+     * @param loadoutName The name of the loadout.
+     * @return true if at least one process of the loadout is tracked.
+     */
+    static bool IsLoadoutLaunched(const std::string &loadoutName);
+
+    /**
+     * @brief Visit every tracked process while the process list is locked.
+     * @param visit Called once per process. Must not call back into AutoStarter.
+     */
+    static void ForEachProcess(const std::function<void(const LaunchedProcess &)> &visit);
+
     /**
      * @brief Remove process handles from internal tracking. Used after quitting programs.
      */
     static void ClearProcesses();
 
+    /**
+     * @brief Stop tracking the programs that exited on their own.
+     * Call outside of exit notifications, e.g. when their status arrives on the UI thread.
+     */
+    static void PruneExited();
+
+    /**
+     * @brief Find the programs a crashed session left running and track them again.
+     * @param quit true to quit the recovered programs instead of tracking them.
+     */
+    static void RecoverProcesses(bool quit);
+
+    /**
+     * @brief Only log launches instead of starting programs, for every way a
+     *        loadout can be launched.
+     * @param enabled true to skip launches from now on.
+     */
+    static void SetDryRun(bool enabled);
+
+    /**
+     * @brief Check whether launches are only logged, see SetDryRun().
+     */
+    static bool IsDryRun();
+
 private:
-    static std::vector<HANDLE> launchedProcesses;
+    friend class LaunchJob;
+
+    /**
+     * @brief Outcome of WaitUntilReady().
+     */
+    enum class Readiness {
+        Ready,     ///< Ready for input, or without a user interface
+        TimedOut,  ///< Still not ready when the timeout elapsed
+        Cancelled, ///< The wait was cancelled before the program got ready
+        Untracked  ///< Not tracked, or adopted instead of spawned
+    };
+
+    static std::vector<LaunchedProcess> launchedProcesses;
+    static std::mutex processMutex; ///< Guards launchedProcesses
+    static std::atomic<bool> dryRun;
 
     /**
-     * @brief Launch an individual program.
-     * @param program Program data containing path, executable, minimized flag.
+     * @brief Launch an individual program from its precompiled plan.
+     * @param loadout Compiled loadout the program belongs to.
+     * @param index Index of the program within the loadout.
+     * @param errorCode Receives the Windows error code on failure.
      * @return true if successfully launched, false on failure.
      */
-    static bool LaunchProgram(const Program &program);
+    static bool LaunchProgram(const std::shared_ptr<const LoadoutPlan> &loadout,
+                              size_t index, unsigned long &errorCode);
+
+    /**
+     * @brief Wait until a program launched from a plan is ready for input.
+     * @param loadout Compiled loadout the program belongs to.
+     * @param index Index of the program within the loadout.
+     * @param timeoutMs Longest time to wait.
+     * @param cancelled Checked while waiting, the wait ends once it is set.
+     * @return How the wait ended. Programs without a user interface are ready
+     *         right away.
+     */
+    static Readiness WaitUntilReady(const std::shared_ptr<const LoadoutPlan> &loadout,
+                                    size_t index, unsigned long timeoutMs,
+                                    const std::atomic<bool> &cancelled);
+
+    /**
+     * @brief Track a program that another OBS instance already launched.
+     * @param loadout Compiled loadout the program belongs to.
+     * @param index Index of the program within the loadout.
+     * @param path Resolved path of the program.
+     * @param processId ID of the running process.
+     * @param registryEntry Shared launch registry entry of the program.
+     * @return true if the process is now tracked, false if it could not be opened.
+     */
+    static bool AdoptProcess(const std::shared_ptr<const LoadoutPlan> &loadout,
+                             size_t index, const std::wstring &path,
+                             unsigned long processId, int registryEntry);
+
+    /**
+     * @brief Track a program this instance already runs for one more loadout, without
+     *        asking the launch registry again.
+     * @param loadout Compiled loadout the program belongs to.
+     * @param index Index of the program within the loadout.
+     * @param path Resolved path of the program.
+     * @return true if the program already runs, false if it must be launched.
+     */
+    static bool ShareTracked(const std::shared_ptr<const LoadoutPlan> &loadout,
+                             size_t index, const std::wstring &path);
+
+    /**
+     * @brief Attempt to quit a specific process, unless another loadout or OBS instance still uses it.
+     * @param process The tracked process.
+     * @return true on success, false otherwise.
+     */
+    static bool QuitProcess(const LaunchedProcess &process);
 
     /**
-     * @brief Attempt to quit a specific process.
+     * @brief Suspend or resume every thread of a process.
      * @param process Windows process handle.
+     * @param frozen true to suspend, false to resume.
      * @return true on success, false otherwise.
      */
-    static bool QuitProcess(HANDLE process);
+    static bool SetProcessFrozen(HANDLE process, bool frozen);
 
     /**
      * @brief Check if a process with the given executable name is already running.
-     * @param executableName The filename (e.g., "notepad.exe").
+     * @param imageName The filename (e.g., L"notepad.exe").
      * @return true if at least one matching process is found, false otherwise.
      */
-    static bool IsProcessRunning(const std::string& executableName);
+    static bool IsProcessRunning(const std::wstring &imageName);
 };
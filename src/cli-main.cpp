@@ -0,0 +1,256 @@
+/**
+ * @file cli-main.cpp
+ * @brief Command line front end of the launcher core
+ *
+ * Usage: autostarter-cli [--config <dir>] [--verbose] <command> <loadout>
+ * where <command> is launch, quit or status.
+ *
+ * Reads the same config.json as the OBS plugin, so loadouts can be driven
+ * from scripts or the task scheduler while OBS is closed. Programs are
+ * recorded in the shared launch journal, so a later quit call or the next
+ * OBS start picks them up again. A status call only reads the journal, and
+ * a quit call leaves the programs of running OBS instances alone.
+ */
+
+#include <windows.h>
+#include "host.hpp"
+#include "config.hpp"
+#include "autostart.hpp"
+#include "launch-plan.hpp"
+#include "launch-registry.hpp"
+#include "launch-journal.hpp"
+#include <QCoreApplication>
+#include <QString>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+static std::string configDirectory;
+static bool verbose = false;
+
+static void Log(Host::Level level, const char *message)
+{
+	if (verbose || level <= Host::Warning)
+		fprintf(stderr, "%s\n", message);
+}
+
+static std::string ConfigPath(const char *file)
+{
+	return configDirectory + file;
+}
+
+/**
+ * @brief Returns the plugin config directory OBS uses for this plugin
+ */
+static std::string DefaultConfigDirectory()
+{
+	const char *appData = getenv("APPDATA");
+	if (!appData)
+		return std::string();
+	return std::string(appData) + "/obs-studio/plugin_config/autostarter/";
+}
+
+static int Usage()
+{
+	fprintf(stderr,
+		"Usage: autostarter-cli [--config <dir>] [--verbose] launch|quit|status <loadout>\n");
+	return 2;
+}
+
+/**
+ * @brief Returns whether a journal entry still refers to a running process
+ */
+static bool IsRunning(const LaunchJournal::Entry &entry)
+{
+	HANDLE process = OpenProcess(
+		SYNCHRONIZE | PROCESS_QUERY_LIMITED_INFORMATION, FALSE,
+		entry.processId);
+	if (!process)
+		return false;
+
+	// The start time tells a reused ID apart
+	FILETIME creation, exit, kernel, user;
+	bool running =
+		WaitForSingleObject(process, 0) == WAIT_TIMEOUT &&
+		GetProcessTimes(process, &creation, &exit, &kernel, &user) &&
+		(((uint64_t)creation.dwHighDateTime << 32) |
+		 creation.dwLowDateTime) == entry.startTime;
+	CloseHandle(process);
+	return running;
+}
+
+/**
+ * @brief Returns the display name of a recorded program, or its file name
+ * if the loadout no longer contains it
+ */
+static std::string DisplayName(const LoadoutPlan *plan,
+			       const LaunchJournal::Entry &entry)
+{
+	for (size_t i = 0; plan && i < plan->programs.size(); i++) {
+		const LaunchPlan &program = plan->programs[i];
+		if (_wcsicmp(program.fullPath.c_str(), entry.path.c_str()) == 0)
+			return program.displayName;
+	}
+
+	std::wstring fileName =
+		entry.path.substr(entry.path.find_last_of(L'\\') + 1);
+	return QString::fromStdWString(fileName).toStdString();
+}
+
+/**
+ * @brief Lists the recorded programs of a loadout without taking them over,
+ * so the journal stays as the plugin or an earlier call left it
+ */
+static int Status(const std::string &loadout)
+{
+	auto plan = PluginConfig::Get().GetPlan(loadout);
+	int running = 0;
+	for (const auto &entry : LaunchJournal::LoadAll()) {
+		if (entry.loadout != loadout)
+			continue;
+
+		bool alive = IsRunning(entry);
+		printf("%-32s %-8s PID %lu\n",
+		       DisplayName(plan.get(), entry).c_str(),
+		       alive ? "running" : "exited", entry.processId);
+		if (alive)
+			running++;
+	}
+	printf("Loadout '%s': %d programs running\n", loadout.c_str(),
+	       running);
+	return 0;
+}
+
+/**
+ * @brief Quits the recorded programs of a loadout that no running OBS
+ * instance owns or shares. Reads the journal like Status() and only removes
+ * the programs it quit, the others stay with their owners.
+ * @return 0 if every running program quit, 1 if any was kept or failed.
+ */
+static int Quit(const std::string &loadout)
+{
+	auto plan = PluginConfig::Get().GetPlan(loadout);
+	int quit = 0;
+	int kept = 0;
+	for (const auto &entry : LaunchJournal::LoadAll()) {
+		if (entry.loadout != loadout || !IsRunning(entry))
+			continue;
+
+		std::string name = DisplayName(plan.get(), entry);
+		if (entry.ownerRunning) {
+			printf("%-32s %-8s PID %lu, owned by a running OBS instance\n",
+			       name.c_str(), "kept", entry.processId);
+			kept++;
+			continue;
+		}
+
+		HANDLE process = OpenProcess(PROCESS_TERMINATE | SYNCHRONIZE,
+					     FALSE, entry.processId);
+		if (!process) {
+			printf("%-32s %-8s PID %lu, error code %lu\n",
+			       name.c_str(), "failed", entry.processId,
+			       GetLastError());
+			kept++;
+			continue;
+		}
+
+		// Programs a running instance shares are never quit here
+		int registryEntry = -1;
+		unsigned long sharedProcessId = 0;
+		if (LaunchRegistry::TryAcquire(entry.path, registryEntry,
+					       sharedProcessId) ==
+		    LaunchRegistry::Acquisition::Spawn)
+			LaunchRegistry::Publish(registryEntry, entry.processId);
+
+		auto termination = LaunchRegistry::BeginTerminate(registryEntry);
+		bool terminated = false;
+		unsigned long errorCode = 0;
+		if (termination == LaunchRegistry::Termination::Terminate) {
+			terminated = TerminateProcess(process, 0);
+			if (!terminated)
+				errorCode = GetLastError();
+			LaunchRegistry::EndTerminate(registryEntry);
+		}
+		CloseHandle(process);
+
+		if (terminated) {
+			LaunchJournal::Remove(entry.processId);
+			printf("%-32s %-8s PID %lu\n", name.c_str(), "quit",
+			       entry.processId);
+			quit++;
+		} else if (termination ==
+			   LaunchRegistry::Termination::UsedElsewhere) {
+			printf("%-32s %-8s PID %lu, used by a running OBS instance\n",
+			       name.c_str(), "kept", entry.processId);
+			kept++;
+		} else {
+			printf("%-32s %-8s PID %lu, error code %lu\n",
+			       name.c_str(), "failed", entry.processId,
+			       errorCode);
+			kept++;
+		}
+	}
+	printf("Loadout '%s': %d programs quit, %d not quit\n",
+	       loadout.c_str(), quit, kept);
+	return kept == 0 ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication app(argc, argv);
+
+	configDirectory = DefaultConfigDirectory();
+	std::string command;
+	std::string loadout;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+			configDirectory = argv[++i];
+			if (!configDirectory.empty() &&
+			    configDirectory.back() != '/' &&
+			    configDirectory.back() != '\\')
+				configDirectory += '/';
+		} else if (strcmp(argv[i], "--verbose") == 0) {
+			verbose = true;
+		} else if (command.empty()) {
+			command = argv[i];
+		} else if (loadout.empty()) {
+			loadout = argv[i];
+		} else {
+			return Usage();
+		}
+	}
+	if (loadout.empty() ||
+	    (command != "launch" && command != "quit" && command != "status"))
+		return Usage();
+
+	Host::Callbacks callbacks;
+	callbacks.log = Log;
+	callbacks.configPath = ConfigPath;
+	Host::Install(callbacks);
+
+	PluginConfig::Get().Load();
+	if (!PluginConfig::Get().GetLoadout(loadout)) {
+		fprintf(stderr, "Loadout '%s' not found in %sconfig.json\n",
+			loadout.c_str(), configDirectory.c_str());
+		return 1;
+	}
+
+	if (command == "status")
+		return Status(loadout);
+
+	// Programs shared with running OBS instances are never quit here
+	LaunchRegistry::Open();
+	int result = 0;
+	if (command == "launch") {
+		result = AutoStarter::LaunchPrograms(loadout) ? 0 : 1;
+	} else {
+		result = Quit(loadout);
+	}
+
+	// The journal keeps the programs for the next call, registry slots of
+	// this process are pruned once it has exited
+	LaunchJournal::Flush();
+	LaunchRegistry::Close();
+	return result;
+}
@@ -1,9 +1,45 @@
 #include "config.hpp"
-#include <obs-module.h>
-#include <util/platform.h>
+#include "launch-plan.hpp"
+#include "trace.hpp"
+#include "integrity.hpp"
+#include "host.hpp"
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QStandardPaths>
+#include <functional>
+#include <set>
+#include <vector>
+
+const char *TriggerToString(LaunchTrigger trigger)
+{
+	switch (trigger) {
+	case LaunchTrigger::Streaming:
+		return "streaming";
+	case LaunchTrigger::Recording:
+		return "recording";
+	case LaunchTrigger::ReplayBuffer:
+		return "replayBuffer";
+	case LaunchTrigger::Startup:
+		break;
+	}
+	return "startup";
+}
+
+namespace {
+
+LaunchTrigger TriggerFromString(const QString &trigger)
+{
+	if (trigger == "streaming")
+		return LaunchTrigger::Streaming;
+	if (trigger == "recording")
+		return LaunchTrigger::Recording;
+	if (trigger == "replayBuffer")
+		return LaunchTrigger::ReplayBuffer;
+	return LaunchTrigger::Startup;
+}
+
+} // namespace
 
 /**
  * @brief Returns the singleton instance of PluginConfig
@@ -20,15 +56,7 @@ PluginConfig& PluginConfig::Get()
  */
 QString PluginConfig::GetConfigPath()
 {
-	char *config_dir = obs_module_config_path("");
-	if (!config_dir)
-		return QString();
-
-	QString path = QString::fromUtf8(config_dir);
-	bfree(config_dir);
-
-	QDir().mkpath(path);
-	return path + "config.json";
+	return QString::fromStdString(Host::ConfigPath("config.json"));
 }
 
 /**
@@ -43,6 +71,12 @@ QJsonObject PluginConfig::ToJson() const
 	json["currentLoadout"] = QString::fromStdString(currentLoadout);
 	json["askToLaunch"] = askToLaunch;
 	json["autoclose"] = autoclose;
+	json["quitRecoveredPrograms"] = quitRecoveredPrograms;
+	json["cpuWarningPercent"] = cpuWarningPercent;
+	json["memoryWarningMB"] = memoryWarningMB;
+	json["maxParallelLaunches"] = maxParallelLaunches;
+	json["cpuPressureHigh"] = cpuPressureHigh;
+	json["memoryPressureHigh"] = memoryPressureHigh;
 
 	// Serialize loadouts array
 	QJsonArray loadoutsArray;
@@ -50,6 +84,15 @@ QJsonObject PluginConfig::ToJson() const
 		// Create loadout object
 		QJsonObject loadoutObj;
 		loadoutObj["name"] = QString::fromStdString(loadout.name);
+		loadoutObj["trigger"] = TriggerToString(loadout.trigger);
+		loadoutObj["freezeWhenIdle"] = loadout.freezeWhenIdle;
+		if (!loadout.includes.empty()) {
+			QJsonArray includesArray;
+			for (const auto &include : loadout.includes)
+				includesArray.append(
+					QString::fromStdString(include));
+			loadoutObj["includes"] = includesArray;
+		}
 
 		// Serialize programs in loadout
 		QJsonArray programsArray;
@@ -60,6 +103,22 @@ QJsonObject PluginConfig::ToJson() const
 			programObj["executable"] =
 				QString::fromStdString(program.executable);
 			programObj["minimized"] = program.minimized;
+			programObj["captureOutput"] = program.captureOutput;
+			if (!program.arguments.empty())
+				programObj["arguments"] = QString::fromStdString(
+					program.arguments);
+			if (!program.environment.empty()) {
+				QJsonObject environmentObj;
+				for (const auto &[name, value] :
+				     program.environment)
+					environmentObj[QString::fromStdString(
+						name)] =
+						QString::fromStdString(value);
+				programObj["environment"] = environmentObj;
+			}
+			if (!program.sha256.empty())
+				programObj["sha256"] =
+					QString::fromStdString(program.sha256);
 			programsArray.append(programObj);
 		}
 		loadoutObj["programs"] = programsArray;
@@ -82,6 +141,12 @@ void PluginConfig::FromJson(const QJsonObject &json)
 	currentLoadout = json["currentLoadout"].toString().toStdString();
 	askToLaunch = json["askToLaunch"].toBool(true);
 	autoclose = json["autoclose"].toBool(false);
+	quitRecoveredPrograms = json["quitRecoveredPrograms"].toBool(false);
+	cpuWarningPercent = json["cpuWarningPercent"].toDouble(50.0);
+	memoryWarningMB = json["memoryWarningMB"].toInt(2048);
+	maxParallelLaunches = json["maxParallelLaunches"].toInt(4);
+	cpuPressureHigh = json["cpuPressureHigh"].toDouble(85.0);
+	memoryPressureHigh = json["memoryPressureHigh"].toDouble(90.0);
 
 	// Parse loadouts array
 	loadouts.clear();
@@ -90,6 +155,13 @@ void PluginConfig::FromJson(const QJsonObject &json)
 		QJsonObject loadoutObj = loadoutVal.toObject();
 		Loadout loadout;
 		loadout.name = loadoutObj["name"].toString().toStdString();
+		loadout.trigger =
+			TriggerFromString(loadoutObj["trigger"].toString());
+		loadout.freezeWhenIdle =
+			loadoutObj["freezeWhenIdle"].toBool(false);
+		for (const auto &includeVal : loadoutObj["includes"].toArray())
+			loadout.includes.push_back(
+				includeVal.toString().toStdString());
 
 		QJsonArray programsArray = loadoutObj["programs"].toArray();
 		for (const auto &programVal : programsArray) {
@@ -101,6 +173,28 @@ void PluginConfig::FromJson(const QJsonObject &json)
 						     .toString()
 						     .toStdString();
 			program.minimized = programObj["minimized"].toBool(false);
+			program.captureOutput =
+				programObj["captureOutput"].toBool(false);
+			program.arguments = programObj["arguments"]
+						    .toString()
+						    .toStdString();
+			QJsonObject environmentObj =
+				programObj["environment"].toObject();
+			for (auto it = environmentObj.begin();
+			     it != environmentObj.end(); ++it)
+				program.environment[it.key().toStdString()] =
+					it.value().toString().toStdString();
+			program.sha256 = programObj["sha256"]
+						 .toString()
+						 .toLower()
+						 .toStdString();
+			if (!program.sha256.empty() &&
+			    !Integrity::IsDigest(program.sha256)) {
+				Host::Log(Host::Warning,
+					  "Ignoring invalid SHA-256 of '%s'",
+					  program.executable.c_str());
+				program.sha256.clear();
+			}
 			loadout.programs.push_back(program);
 		}
 
@@ -111,6 +205,8 @@ void PluginConfig::FromJson(const QJsonObject &json)
 void PluginConfig::Save()
 {
 	QString configPath = GetConfigPath();
+	// Only create the config directory when something is written to it
+	QDir().mkpath(QFileInfo(configPath).absolutePath());
 	QFile file(configPath);
 	if (!file.open(QIODevice::WriteOnly)) {
 		return;
@@ -123,6 +219,7 @@ void PluginConfig::Save()
 
 void PluginConfig::Load()
 {
+	TraceSpan span("PluginConfig::Load", "config");
 	QString configPath = GetConfigPath();
 	QFile file(configPath);
 	if (!file.open(QIODevice::ReadOnly)) {
@@ -135,9 +232,76 @@ void PluginConfig::Load()
 	if (doc.isObject()) {
 		FromJson(doc.object());
 	}
+
+	Publish();
+}
+
+void PluginConfig::Commit(const ConfigData &draft)
+{
+	static_cast<ConfigData &>(*this) = draft;
+	Publish();
+	Save();
 }
 
-bool PluginConfig::AddLoadout(const std::string &name)
+void PluginConfig::Publish()
+{
+	auto previous = Snapshot();
+	auto next = std::make_shared<ConfigSnapshot>();
+	static_cast<ConfigData &>(*next) = *this;
+	next->version = previous->version + 1;
+
+	// A plan is stale if its loadout or any loadout it reaches through
+	// includes changed. Each plan walks its includes on its own, results
+	// taken in the middle of an include cycle would be incomplete.
+	auto isStale = [&](const std::string &root) {
+		std::set<std::string> visited;
+		std::vector<std::string> pending{root};
+		while (!pending.empty()) {
+			std::string name = std::move(pending.back());
+			pending.pop_back();
+			if (!visited.insert(name).second)
+				continue;
+
+			const Loadout *current = next->GetLoadout(name);
+			const Loadout *old = previous->GetLoadout(name);
+			if (!current || !old || *current != *old)
+				return true;
+			pending.insert(pending.end(), current->includes.begin(),
+				       current->includes.end());
+		}
+		return false;
+	};
+
+	size_t compiled = 0;
+	for (const auto &loadout : next->loadouts) {
+		auto plan = previous->GetPlan(loadout.name);
+		if (!plan || isStale(loadout.name)) {
+			plan = LoadoutPlan::Compile(loadout, *next);
+			compiled++;
+		}
+		next->plans[loadout.name] = std::move(plan);
+	}
+	Host::Log(Host::Debug,
+		  "Published config version %llu, compiled %zu of %zu plans",
+		  (unsigned long long)next->version, compiled,
+		  next->loadouts.size());
+
+	std::atomic_store(&snapshot,
+			  std::shared_ptr<const ConfigSnapshot>(std::move(next)));
+}
+
+std::shared_ptr<const ConfigSnapshot> PluginConfig::Snapshot() const
+{
+	return std::atomic_load(&snapshot);
+}
+
+std::shared_ptr<const LoadoutPlan>
+PluginConfig::GetPlan(const std::string &name) const
+{
+	return Snapshot()->GetPlan(name);
+}
+
+bool ConfigData::AddLoadout(const std::string &name)
 {
 	Loadout loadout;
 	loadout.name = name;
@@ -152,16 +316,22 @@ bool PluginConfig::AddLoadout(const std::string &name)
 	return true;
 }
 
-void PluginConfig::RemoveLoadout(const std::string &name)
+void ConfigData::RemoveLoadout(const std::string &name)
 {
 	loadouts.erase(std::remove_if(loadouts.begin(), loadouts.end(),
 				      [&name](const Loadout &l) {
 					      return l.name == name;
 				      }),
 		       loadouts.end());
+	for (auto &loadout : loadouts) {
+		auto &includes = loadout.includes;
+		includes.erase(std::remove(includes.begin(), includes.end(),
+					   name),
+			       includes.end());
+	}
 }
 
-Loadout *PluginConfig::GetLoadout(const std::string &name)
+Loadout *ConfigData::GetLoadout(const std::string &name)
 {
 	auto it = std::find_if(loadouts.begin(), loadouts.end(),
 			       [&name](const Loadout &l) {
@@ -170,9 +340,45 @@ Loadout *PluginConfig::GetLoadout(const std::string &name)
 	return it != loadouts.end() ? &(*it) : nullptr;
 }
 
-void PluginConfig::InitDefaultLoadout()
+const Loadout *ConfigData::GetLoadout(const std::string &name) const
+{
+	return const_cast<ConfigData *>(this)->GetLoadout(name);
+}
+
+bool ConfigData::HasIncludeCycle(const std::string &name) const
+{
+	std::vector<std::string> path;
+	std::function<bool(const std::string &)> visit =
+		[&](const std::string &current) {
+			if (std::find(path.begin(), path.end(), current) !=
+			    path.end())
+				return true;
+
+			const Loadout *loadout = GetLoadout(current);
+			if (!loadout)
+				return false;
+
+			path.push_back(current);
+			for (const auto &include : loadout->includes) {
+				if (visit(include))
+					return true;
+			}
+			path.pop_back();
+			return false;
+		};
+	return visit(name);
+}
+
+void ConfigData::InitDefaultLoadout()
 {
 	Loadout loadout;
 	loadout.name = "Default";
 	loadouts.push_back(loadout);
 }
+
+std::shared_ptr<const LoadoutPlan>
+ConfigSnapshot::GetPlan(const std::string &name) const
+{
+	auto it = plans.find(name);
+	return it != plans.end() ? it->second : nullptr;
+}
@@ -1,4 +1,6 @@
 #pragma once
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 #include <QJsonObject>
@@ -12,30 +14,137 @@ struct Program {
     std::string path;        ///< Full path to the program directory
     std::string executable;  ///< Name of the executable file
     bool minimized = false;  ///< Whether to start the program minimized
+    std::string arguments;   ///< Command line arguments passed to the program
+    std::map<std::string, std::string> environment; ///< Environment overrides, empty value removes the variable
+    bool captureOutput = false; ///< Whether stdout and stderr are written to a log file
+    std::string sha256;      ///< Pinned SHA-256 of the file in lowercase hex, empty if not pinned
+
+    bool operator==(const Program &other) const
+    {
+        return path == other.path && executable == other.executable &&
+               minimized == other.minimized && arguments == other.arguments &&
+               environment == other.environment &&
+               captureOutput == other.captureOutput && sha256 == other.sha256;
+    }
+    bool operator!=(const Program &other) const { return !(*this == other); }
+};
+
+/**
+ * @brief OBS event that launches a loadout.
+ */
+enum class LaunchTrigger {
+    Startup,     ///< Launched when OBS starts
+    Streaming,   ///< Launched when streaming starts, quit when it stops
+    Recording,   ///< Launched when recording starts, quit when it stops
+    ReplayBuffer ///< Launched when the replay buffer starts, quit when it stops
 };
 
+/**
+ * @brief Returns the name a trigger is stored under in the config, also used in logs.
+ */
+const char *TriggerToString(LaunchTrigger trigger);
+
 /**
  * @brief Represents a collection of programs that can be launched together.
  */
 struct Loadout {
     std::string name;              ///< Unique name of the loadout
     std::vector<Program> programs; ///< List of programs in this loadout
+    LaunchTrigger trigger = LaunchTrigger::Startup; ///< When the loadout is launched
+    bool freezeWhenIdle = false;   ///< Suspend the programs while no output is active
+    std::vector<std::string> includes; ///< Names of loadouts whose programs are launched as well
+
+    bool operator==(const Loadout &other) const
+    {
+        return name == other.name && programs == other.programs &&
+               trigger == other.trigger &&
+               freezeWhenIdle == other.freezeWhenIdle &&
+               includes == other.includes;
+    }
+    bool operator!=(const Loadout &other) const { return !(*this == other); }
 };
 
+struct LoadoutPlan;
+
 /**
- * @brief Manages plugin configurations and loadouts using a singleton pattern.
- * 
- * This class handles saving and loading of plugin configuration, including
- * multiple loadouts of programs that can be launched when OBS starts.
+ * @brief Plain configuration values that can be copied for drafts and snapshots.
  */
-class PluginConfig {
-public:
+struct ConfigData {
     bool enabled = false;           ///< Whether the plugin is currently enabled
     std::string currentLoadout;     ///< Name of the currently selected loadout
     std::vector<Loadout> loadouts;  ///< List of all available loadouts
     bool askToLaunch = true;        ///< Whether to ask before launching programs
     bool autoclose = false;         ///< Whether to close programs when OBS exits
+    bool quitRecoveredPrograms = false; ///< Quit programs left over from a crashed session instead of tracking them again
+    double cpuWarningPercent = 50.0; ///< CPU usage per program that logs a warning, 0 to disable
+    int memoryWarningMB = 2048;     ///< Memory usage per program that logs a warning, 0 to disable
+    int maxParallelLaunches = 4;    ///< Upper bound for programs spawned at once
+    double cpuPressureHigh = 85.0;  ///< System CPU usage in percent above which spawning backs off
+    double memoryPressureHigh = 90.0; ///< System memory load in percent above which spawning backs off
+
+    /**
+     * @brief Adds a new loadout with the specified name.
+     * @param name The name for the new loadout
+     * @return true if added successfully, false if name already exists
+     */
+    bool AddLoadout(const std::string &name);
+
+    /**
+     * @brief Removes a loadout with the specified name and every include of it.
+     * @param name The name of the loadout to remove
+     */
+    void RemoveLoadout(const std::string &name);
+
+    /**
+     * @brief Finds and returns a loadout by name.
+     * @param name The name of the loadout to find
+     * @return Pointer to the loadout if found, nullptr otherwise
+     */
+    Loadout *GetLoadout(const std::string &name);
+    const Loadout *GetLoadout(const std::string &name) const;
+
+    /**
+     * @brief Checks whether a loadout can reach itself through its includes.
+     * @param name The name of the loadout to check
+     * @return true if following the includes of the loadout runs into a cycle
+     */
+    bool HasIncludeCycle(const std::string &name) const;
 
+    /**
+     * @brief Creates a default loadout configuration.
+     */
+    void InitDefaultLoadout();
+};
+
+/**
+ * @brief Immutable published version of the configuration.
+ *
+ * Background threads hold on to a snapshot for as long as they need it, so
+ * they never observe a configuration that is being edited.
+ */
+struct ConfigSnapshot : ConfigData {
+    uint64_t version = 0; ///< Increases with every published snapshot
+    std::map<std::string, std::shared_ptr<const LoadoutPlan>> plans; ///< Compiled plan per loadout
+
+    /**
+     * @brief Returns the compiled launch plan of a loadout.
+     * @param name The name of the loadout
+     * @return The compiled plan, or nullptr if the loadout does not exist
+     */
+    std::shared_ptr<const LoadoutPlan> GetPlan(const std::string &name) const;
+};
+
+/**
+ * @brief Manages plugin configurations and loadouts using a singleton pattern.
+ * 
+ * This class handles saving and loading of plugin configuration, including
+ * multiple loadouts of programs that can be launched when OBS starts.
+ *
+ * The public values are the working copy and may only be used on the UI
+ * thread. Every other thread reads the latest published Snapshot().
+ */
+class PluginConfig : public ConfigData {
+public:
     /**
      * @brief Retrieves the singleton instance of PluginConfig.
      * @return Reference to the singleton instance.
@@ -51,33 +160,41 @@ public:
      * @brief Loads configuration from disk, creates default if none exists.
      */
     void Load();
-    
+
     /**
-     * @brief Adds a new loadout with the specified name.
-     * @param name The name for the new loadout
-     * @return true if added successfully, false if name already exists
+     * @brief Replaces the configuration with an edited draft, publishes and saves it.
+     * @param draft The edited copy of the configuration
      */
-    bool AddLoadout(const std::string &name);
+    void Commit(const ConfigData &draft);
 
     /**
-     * @brief Removes a loadout with the specified name.
-     * @param name The name of the loadout to remove
+     * @brief Compiles the launch plans and atomically publishes a new snapshot.
+     *
+     * Must be called after the working copy was edited. Plans are only
+     * recompiled for loadouts that changed or include a changed loadout,
+     * all others are shared with the previous snapshot.
      */
-    void RemoveLoadout(const std::string &name);
+    void Publish();
 
     /**
-     * @brief Finds and returns a loadout by name.
-     * @param name The name of the loadout to find
-     * @return Pointer to the loadout if found, nullptr otherwise
+     * @brief Returns the latest published configuration. Safe on any thread.
      */
-    Loadout *GetLoadout(const std::string &name);
+    std::shared_ptr<const ConfigSnapshot> Snapshot() const;
 
     /**
-     * @brief Creates a default loadout configuration.
+     * @brief Returns the compiled launch plan of a loadout from the latest snapshot.
+     * @param name The name of the loadout
+     * @return The compiled plan, or nullptr if the loadout does not exist
      */
-    void InitDefaultLoadout();
+    std::shared_ptr<const LoadoutPlan> GetPlan(const std::string &name) const;
 
 private:
+    /**
+     * @brief Latest published snapshot, only accessed through std::atomic_load and std::atomic_store.
+     */
+    std::shared_ptr<const ConfigSnapshot> snapshot =
+        std::make_shared<const ConfigSnapshot>();
+
     PluginConfig() = default;
     QString GetConfigPath();
     QJsonObject ToJson() const;
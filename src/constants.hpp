@@ -17,6 +17,43 @@ namespace Constants {
     inline const int DEFAULT_WINDOW_WIDTH = 400;
     inline const int DEFAULT_WINDOW_HEIGHT = 550;
 
+    // Resource sampling
+    inline const int SAMPLE_INTERVAL_MS = 1000;
+    inline const size_t SAMPLE_HISTORY_SIZE = 60;
+
+    // Share of OBS startup the plugin may take before a warning is logged
+    inline const double STARTUP_BUDGET_MS = 25.0;
+    // Heap blocks obs_module_load may leave allocated, checked by tests/startup-test.cpp.
+    // Derive it from the count that test prints for the default config on a Release
+    // build, plus about a quarter of headroom for Qt and C runtime differences
+    // between machines.
+    inline const size_t STARTUP_ALLOCATION_BUDGET = 4000;
+    // Mean cost of one autostarter_status call, checked by tests/procedure-test.cpp
+    inline const double PROCEDURE_CALL_BUDGET_US = 5.0;
+
+    // Launch tracing
+    inline const size_t TRACE_BUFFER_SIZE = 4096;
+
+    // Captured program output
+    inline const unsigned long long OUTPUT_LOG_MAX_BYTES = 1024 * 1024;
+    inline const int OUTPUT_LOG_MAX_FILES = 3;
+
+    // Changes to the launch journal within this window are written at once
+    inline const int JOURNAL_WRITE_DELAY_MS = 250;
+
+    // Launch history, weight of the newest launch in the averages
+    inline const double LAUNCH_HISTORY_WEIGHT = 0.3;
+    // Longest wait for a program to become ready for input
+    inline const unsigned long READY_TIMEOUT_MS = 30000;
+    // Ready waits check for cancellation this often
+    inline const unsigned long READY_POLL_MS = 100;
+
+    // A supervisor request not answered within this time abandons the helper
+    inline const unsigned long SUPERVISOR_TIMEOUT_MS = 5000;
+
+    // Process state changes are delivered to the UI at most once per frame
+    inline const int STATUS_BATCH_INTERVAL_MS = 16;
+
     // UI text
     inline const std::string WINDOW_TITLE = "Autostarter Settings";
 }
@@ -0,0 +1,207 @@
+// Caches the open commands of file types to start document handlers directly
+#include <windows.h>
+#include <shlwapi.h>
+#include "file-handlers.hpp"
+#include "host.hpp"
+#include <algorithm>
+#include <cwctype>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+/**
+ * @brief Registry keys whose changes can alter a file association.
+ */
+const struct {
+	HKEY root;
+	const wchar_t *path;
+} watchedKeys[] = {
+	{HKEY_CURRENT_USER, L"Software\\Classes"},
+	{HKEY_CURRENT_USER,
+	 L"Software\\Microsoft\\Windows\\CurrentVersion\\Explorer\\FileExts"},
+	{HKEY_LOCAL_MACHINE, L"Software\\Classes"},
+};
+constexpr size_t WatchedKeyCount = sizeof(watchedKeys) / sizeof(watchedKeys[0]);
+
+std::mutex handlerMutex;
+bool watching = false;
+HANDLE changedEvent = nullptr;
+HKEY keys[WatchedKeyCount] = {};
+std::unordered_map<std::wstring, std::wstring> commands; ///< Open command by lowercase extension, empty if none
+
+/**
+ * @brief Requests one notification for every watched key. Requires handlerMutex.
+ */
+void Arm()
+{
+	for (HKEY key : keys) {
+		// Thread agnostic, the arming launch thread may exit any time
+		if (key)
+			RegNotifyChangeKeyValue(
+				key, TRUE,
+				REG_NOTIFY_CHANGE_NAME |
+					REG_NOTIFY_CHANGE_LAST_SET |
+					REG_NOTIFY_THREAD_AGNOSTIC,
+				changedEvent, TRUE);
+	}
+}
+
+/**
+ * @brief Starts watching on first use and drops the cache after the
+ * associations changed. Requires handlerMutex.
+ */
+void Refresh()
+{
+	if (!watching) {
+		watching = true;
+		changedEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+		if (!changedEvent)
+			return;
+		for (size_t i = 0; i < WatchedKeyCount; i++)
+			RegOpenKeyExW(watchedKeys[i].root, watchedKeys[i].path,
+				      0, KEY_NOTIFY, &keys[i]);
+		Arm();
+		return;
+	}
+
+	if (changedEvent &&
+	    WaitForSingleObject(changedEvent, 0) == WAIT_OBJECT_0) {
+		ResetEvent(changedEvent);
+		commands.clear();
+		Arm();
+	}
+}
+
+std::wstring QueryCommand(const std::wstring &extension)
+{
+	DWORD size = 0;
+	AssocQueryStringW(ASSOCF_NOTRUNCATE | ASSOCF_INIT_IGNOREUNKNOWN,
+			  ASSOCSTR_COMMAND, extension.c_str(), L"open", nullptr,
+			  &size);
+	if (size == 0)
+		return std::wstring();
+
+	std::wstring command(size, L'\0');
+	if (FAILED(AssocQueryStringW(ASSOCF_NOTRUNCATE |
+					     ASSOCF_INIT_IGNOREUNKNOWN,
+				     ASSOCSTR_COMMAND, extension.c_str(),
+				     L"open", command.data(), &size)))
+		return std::wstring();
+	command.resize(wcslen(command.c_str()));
+
+	DWORD expandedSize =
+		ExpandEnvironmentStringsW(command.c_str(), nullptr, 0);
+	if (expandedSize == 0)
+		return command;
+	std::wstring expanded(expandedSize, L'\0');
+	ExpandEnvironmentStringsW(command.c_str(), expanded.data(),
+				  expandedSize);
+	expanded.resize(wcslen(expanded.c_str()));
+	return expanded;
+}
+
+/**
+ * @brief Substitutes the placeholders of an open command.
+ */
+std::wstring Expand(const std::wstring &command, const std::wstring &path,
+		    const std::wstring &parameters)
+{
+	std::wstring result;
+	bool hasPath = false;
+	bool hasParameters = false;
+	for (size_t i = 0; i < command.size(); i++) {
+		if (command[i] != L'%' || i + 1 == command.size()) {
+			result += command[i];
+			continue;
+		}
+
+		wchar_t placeholder = command[++i];
+		switch (placeholder) {
+		case L'1':
+		case L'L':
+		case L'l':
+			// Quote the path unless the command already does
+			if (!result.empty() && result.back() == L'"')
+				result += path;
+			else
+				result += L"\"" + path + L"\"";
+			hasPath = true;
+			break;
+		case L'*':
+			result += parameters;
+			hasParameters = true;
+			break;
+		case L'%':
+			result += L'%';
+			break;
+		default:
+			// Further arguments and item lists are not passed
+			break;
+		}
+	}
+
+	if (!hasPath)
+		result += L" \"" + path + L"\"";
+	// Like the shell, pass the parameters even without a placeholder
+	if (!hasParameters && !parameters.empty())
+		result += L" " + parameters;
+	return result;
+}
+
+} // namespace
+
+bool FileHandlers::CommandLine(const std::wstring &path,
+			       const std::wstring &parameters,
+			       std::vector<wchar_t> &commandLine)
+{
+	size_t dot = path.rfind(L'.');
+	size_t separator = path.find_last_of(L"\\/");
+	if (dot == std::wstring::npos ||
+	    (separator != std::wstring::npos && dot < separator))
+		return false;
+
+	std::wstring extension = path.substr(dot);
+	std::transform(extension.begin(), extension.end(), extension.begin(),
+		       [](wchar_t c) { return (wchar_t)towlower(c); });
+
+	std::wstring command;
+	{
+		std::lock_guard<std::mutex> lock(handlerMutex);
+		Refresh();
+		auto it = commands.find(extension);
+		if (it == commands.end()) {
+			it = commands.emplace(extension, QueryCommand(extension))
+				     .first;
+			if (it->second.empty())
+				Host::Log(Host::Debug,
+					  "No open command for '%ls', using the shell",
+					  extension.c_str());
+		}
+		command = it->second;
+	}
+	if (command.empty())
+		return false;
+
+	std::wstring expanded = Expand(command, path, parameters);
+	commandLine.assign(expanded.begin(), expanded.end());
+	commandLine.push_back(L'\0');
+	return true;
+}
+
+void FileHandlers::Stop()
+{
+	std::lock_guard<std::mutex> lock(handlerMutex);
+	for (HKEY &key : keys) {
+		if (key) {
+			RegCloseKey(key);
+			key = nullptr;
+		}
+	}
+	if (changedEvent) {
+		CloseHandle(changedEvent);
+		changedEvent = nullptr;
+	}
+	commands.clear();
+	watching = false;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/**
+ * @brief Resolves the program registered to open a document.
+ *
+ * The open command of every file extension is looked up once through the
+ * Windows file associations and cached. Changes to the associations are
+ * picked up through registry change notifications, which clear the cache.
+ * This lets documents be opened with a single CreateProcessW call instead
+ * of a round trip through the shell.
+ */
+class FileHandlers {
+public:
+	/**
+	 * @brief Builds the command line that opens a document in its handler.
+	 * @param path Absolute path of the document.
+	 * @param parameters Arguments configured for the program, used where the command takes them.
+	 * @param commandLine Receives the terminated, mutable command line for CreateProcessW.
+	 * @return true if the extension has a handler that can be started directly.
+	 */
+	static bool CommandLine(const std::wstring &path,
+				const std::wstring &parameters,
+				std::vector<wchar_t> &commandLine);
+
+	/**
+	 * @brief Stops watching the associations and drops the cache.
+	 * The next CommandLine() call starts watching again.
+	 */
+	static void Stop();
+};
@@ -0,0 +1,16 @@
+// Compares frame counters of the host to tell whether launches disturb it
+#include "frame-stats.hpp"
+#include "host.hpp"
+
+FrameStats FrameStats::Sample()
+{
+	return Host::SampleFrames();
+}
+
+bool FrameStats::LostSince(const FrameStats &earlier) const
+{
+	// Dropped frames shrink when an output stops, only growth counts
+	return laggedFrames > earlier.laggedFrames ||
+	       skippedFrames > earlier.skippedFrames ||
+	       droppedFrames > earlier.droppedFrames;
+}
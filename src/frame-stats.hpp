@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * @brief Render and encode health counters of libobs at one point in time.
+ *
+ * All counters only ever grow while OBS runs, so comparing two samples
+ * shows whether frames were lost in between. Hosts without a renderer
+ * report all counters as zero.
+ */
+struct FrameStats {
+	uint32_t laggedFrames = 0;  ///< Frames the renderer missed, see obs_get_lagged_frames()
+	uint32_t skippedFrames = 0; ///< Frames the encoders skipped, see video_output_get_skipped_frames()
+	int64_t droppedFrames = 0;  ///< Frames dropped by all active outputs
+
+	/**
+	 * @brief Reads the current counters through the host. Safe to call
+	 * from any thread.
+	 */
+	static FrameStats Sample();
+
+	/**
+	 * @brief Checks whether any frame was lost since an earlier sample.
+	 * @param earlier The earlier sample.
+	 * @return true if any counter increased.
+	 */
+	bool LostSince(const FrameStats &earlier) const;
+};
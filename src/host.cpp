@@ -0,0 +1,62 @@
+// Routes logging, paths and events of the launcher core to its host
+#include "host.hpp"
+#include <cstdarg>
+#include <cstdio>
+
+namespace {
+
+Host::Callbacks callbacks;
+
+} // namespace
+
+void Host::Install(const Callbacks &installed)
+{
+	callbacks = installed;
+}
+
+void Host::Log(Level level, const char *format, ...)
+{
+	char message[4096];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(message, sizeof(message), format, args);
+	va_end(args);
+
+	if (callbacks.log)
+		callbacks.log(level, message);
+	else
+		fprintf(stderr, "%s\n", message);
+}
+
+std::string Host::ConfigPath(const char *file)
+{
+	if (callbacks.configPath)
+		return callbacks.configPath(file);
+	return file;
+}
+
+FrameStats Host::SampleFrames()
+{
+	return callbacks.frameStats ? callbacks.frameStats() : FrameStats();
+}
+
+void Host::ProgramLaunched(const char *loadout, size_t index,
+			   const char *program, unsigned long processId)
+{
+	if (callbacks.programLaunched)
+		callbacks.programLaunched(loadout, index, program, processId);
+}
+
+void Host::ProgramFailed(const char *loadout, size_t index,
+			 const char *program, unsigned long errorCode)
+{
+	if (callbacks.programFailed)
+		callbacks.programFailed(loadout, index, program, errorCode);
+}
+
+void Host::ProgramExited(const char *loadout, size_t index,
+			 unsigned long processId, unsigned long exitCode)
+{
+	if (callbacks.programExited)
+		callbacks.programExited(loadout, index, processId, exitCode);
+}
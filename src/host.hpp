@@ -0,0 +1,82 @@
+#pragma once
+#include "frame-stats.hpp"
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Everything the launcher core needs from the program hosting it.
+ *
+ * The core (config, planning, launching, tracking) does not depend on
+ * libobs, so it can be driven by the OBS plugin as well as by the
+ * command line tool. The host installs its callbacks once at startup;
+ * until then the defaults log to stderr, keep files in the working
+ * directory, report no frame loss and drop program events.
+ */
+class Host {
+public:
+	/**
+	 * @brief Log levels, numerically equal to the libobs ones.
+	 */
+	enum Level { Error = 100, Warning = 200, Info = 300, Debug = 400 };
+
+	/**
+	 * @brief Host callbacks, nullptr keeps the default.
+	 */
+	struct Callbacks {
+		void (*log)(Level level, const char *message) = nullptr;
+		/** Full path of a file in the configuration directory */
+		std::string (*configPath)(const char *file) = nullptr;
+		FrameStats (*frameStats)() = nullptr;
+		void (*programLaunched)(const char *loadout, size_t index,
+					const char *program,
+					unsigned long processId) = nullptr;
+		void (*programFailed)(const char *loadout, size_t index,
+				      const char *program,
+				      unsigned long errorCode) = nullptr;
+		void (*programExited)(const char *loadout, size_t index,
+				      unsigned long processId,
+				      unsigned long exitCode) = nullptr;
+	};
+
+	/**
+	 * @brief Installs the host callbacks. Call before any other core API.
+	 */
+	static void Install(const Callbacks &callbacks);
+
+	/**
+	 * @brief Formats and logs a message, printf style.
+	 */
+	static void Log(Level level, const char *format, ...);
+
+	/**
+	 * @brief Resolves a file in the configuration directory.
+	 * @param file Relative file name, "" for the directory itself.
+	 * @return The full path, empty if the host has no config directory.
+	 */
+	static std::string ConfigPath(const char *file);
+
+	/**
+	 * @brief Samples the frame counters of the host.
+	 */
+	static FrameStats SampleFrames();
+
+	/**
+	 * @brief Reports a started program to the host.
+	 */
+	static void ProgramLaunched(const char *loadout, size_t index,
+				    const char *program,
+				    unsigned long processId);
+
+	/**
+	 * @brief Reports a program that could not be started to the host.
+	 */
+	static void ProgramFailed(const char *loadout, size_t index,
+				  const char *program, unsigned long errorCode);
+
+	/**
+	 * @brief Reports a tracked program that ended by itself to the host.
+	 */
+	static void ProgramExited(const char *loadout, size_t index,
+				  unsigned long processId,
+				  unsigned long exitCode);
+};
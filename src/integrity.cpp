@@ -0,0 +1,203 @@
+// Hashes programs with SHA-256 and caches the digests by file identity
+#include <windows.h>
+#include <bcrypt.h>
+#include "integrity.hpp"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+namespace {
+
+constexpr DWORD ReadChunkSize = 1024 * 1024;
+
+/**
+ * @brief Identifies one version of a file on disk.
+ */
+struct FileKey {
+	DWORD volumeSerial;
+	uint64_t fileIndex;
+	uint64_t size;
+	uint64_t writeTime;
+
+	bool operator<(const FileKey &other) const
+	{
+		return std::tie(volumeSerial, fileIndex, size, writeTime) <
+		       std::tie(other.volumeSerial, other.fileIndex, other.size,
+				other.writeTime);
+	}
+};
+
+std::mutex cacheMutex;
+std::map<FileKey, std::string> cache;
+
+std::string ToHex(const unsigned char *bytes, size_t length)
+{
+	static const char digits[] = "0123456789abcdef";
+	std::string hex(length * 2, '0');
+	for (size_t i = 0; i < length; i++) {
+		hex[i * 2] = digits[bytes[i] >> 4];
+		hex[i * 2 + 1] = digits[bytes[i] & 0xf];
+	}
+	return hex;
+}
+
+/**
+ * @brief Streams a file through the system SHA-256 provider, which picks
+ * the SHA extensions or vector units of the CPU where available.
+ */
+bool HashFile(HANDLE file, std::string &digest)
+{
+	BCRYPT_HASH_HANDLE hash = nullptr;
+	if (!BCRYPT_SUCCESS(BCryptCreateHash(BCRYPT_SHA256_ALG_HANDLE, &hash,
+					     nullptr, 0, nullptr, 0, 0)))
+		return false;
+
+	auto buffer = std::make_unique<unsigned char[]>(ReadChunkSize);
+	bool success = true;
+	for (;;) {
+		DWORD bytesRead = 0;
+		if (!ReadFile(file, buffer.get(), ReadChunkSize, &bytesRead,
+			      nullptr)) {
+			success = false;
+			break;
+		}
+		if (bytesRead == 0)
+			break;
+		if (!BCRYPT_SUCCESS(BCryptHashData(hash, buffer.get(),
+						   bytesRead, 0))) {
+			success = false;
+			break;
+		}
+	}
+
+	unsigned char result[32];
+	if (success && BCRYPT_SUCCESS(BCryptFinishHash(hash, result,
+						       sizeof(result), 0)))
+		digest = ToHex(result, sizeof(result));
+	else
+		success = false;
+	BCryptDestroyHash(hash);
+	return success;
+}
+
+/**
+ * @brief Opens a file and reads the key that identifies its current version.
+ * @param file Receives the handle, INVALID_HANDLE_VALUE if the open failed.
+ */
+bool OpenIdentified(const std::wstring &path, DWORD shareMode, HANDLE &file,
+		    FileKey &key)
+{
+	file = CreateFileW(path.c_str(), GENERIC_READ, shareMode, nullptr,
+			   OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	BY_HANDLE_FILE_INFORMATION info;
+	if (!GetFileInformationByHandle(file, &info))
+		return false;
+
+	key = {info.dwVolumeSerialNumber,
+	       ((uint64_t)info.nFileIndexHigh << 32) | info.nFileIndexLow,
+	       ((uint64_t)info.nFileSizeHigh << 32) | info.nFileSizeLow,
+	       ((uint64_t)info.ftLastWriteTime.dwHighDateTime << 32) |
+		       info.ftLastWriteTime.dwLowDateTime};
+	return true;
+}
+
+/**
+ * @brief Hashes an opened file and caches its digest.
+ */
+bool HashIdentified(HANDLE file, const FileKey &key, std::string &digest)
+{
+	if (!HashFile(file, digest))
+		return false;
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	cache[key] = digest;
+	return true;
+}
+
+/**
+ * @brief Opens a file and hashes it through the same handle that identifies
+ * it, so the cache key and the digest always describe the same file.
+ * @param file Receives the handle, INVALID_HANDLE_VALUE if the open failed.
+ */
+bool HashOpen(const std::wstring &path, DWORD shareMode, std::string &digest,
+	      HANDLE &file)
+{
+	FileKey key;
+	if (!OpenIdentified(path, shareMode, file, key))
+		return false;
+
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		auto it = cache.find(key);
+		if (it != cache.end()) {
+			digest = it->second;
+			return true;
+		}
+	}
+	return HashIdentified(file, key, digest);
+}
+
+} // namespace
+
+bool Integrity::IsDigest(const std::string &digest)
+{
+	if (digest.size() != 64)
+		return false;
+	for (char c : digest) {
+		if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f')))
+			return false;
+	}
+	return true;
+}
+
+bool Integrity::Hash(const std::wstring &path, std::string &digest)
+{
+	// The digest is only reported, the file may change once it was read
+	HANDLE file = INVALID_HANDLE_VALUE;
+	bool success = HashOpen(path, FILE_SHARE_READ | FILE_SHARE_DELETE,
+				digest, file);
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+	return success;
+}
+
+bool Integrity::HashPinned(const std::wstring &path, std::string &digest,
+			   HANDLE &pin)
+{
+	// Others may still read and run the file, but neither write, rename
+	// nor delete it until the caller closes the handle
+	return HashOpen(path, FILE_SHARE_READ, digest, pin);
+}
+
+bool Integrity::Verify(const std::wstring &path, const std::string &expected,
+		       std::string &actual)
+{
+	actual.clear();
+	return Hash(path, actual) && actual == expected;
+}
+
+bool Integrity::VerifyPinned(const std::wstring &path,
+			     const std::string &expected, std::string &actual,
+			     HANDLE &pin)
+{
+	actual.clear();
+	FileKey key;
+	if (!OpenIdentified(path, FILE_SHARE_READ, pin, key))
+		return false;
+
+	// Compare against the cached digest in place, a match copies nothing
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		auto it = cache.find(key);
+		if (it != cache.end()) {
+			if (it->second == expected)
+				return true;
+			actual = it->second;
+			return false;
+		}
+	}
+	return HashIdentified(pin, key, actual) && actual == expected;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <string>
+
+// Forward declare Windows types
+using HANDLE = void *;
+
+/**
+ * @brief Verifies programs against the SHA-256 digest pinned in the config.
+ *
+ * Digests are cached by volume serial number, file index, size and last
+ * write time, so an unchanged file is only hashed once per session and a
+ * warm check costs a single file open.
+ *
+ * A check only holds while the file cannot change, so launches use the
+ * pinned variants and keep the returned handle open until the program was
+ * spawned. The handle denies writing, renaming and deleting the file.
+ */
+class Integrity {
+public:
+	/**
+	 * @brief Checks whether a string is a SHA-256 digest in lowercase hex.
+	 */
+	static bool IsDigest(const std::string &digest);
+
+	/**
+	 * @brief Computes the SHA-256 digest of a file, using the cache if possible.
+	 * @param path Absolute path of the file.
+	 * @param digest Receives the digest in lowercase hex.
+	 * @return true on success, false if the file could not be read.
+	 */
+	static bool Hash(const std::wstring &path, std::string &digest);
+
+	/**
+	 * @brief Like Hash(), but keeps the file from changing afterwards.
+	 * @param pin Receives the handle that locks the file, or
+	 * INVALID_HANDLE_VALUE if it could not be opened. The caller closes
+	 * it, on failure too.
+	 */
+	static bool HashPinned(const std::wstring &path, std::string &digest,
+			       HANDLE &pin);
+
+	/**
+	 * @brief Compares a file against its pinned digest.
+	 * @param path Absolute path of the file.
+	 * @param expected Pinned digest in lowercase hex.
+	 * @param actual Receives the digest of the file, empty if it could not be read.
+	 * @return true if the file matches.
+	 */
+	static bool Verify(const std::wstring &path, const std::string &expected,
+			   std::string &actual);
+
+	/**
+	 * @brief Like Verify(), but keeps the file from changing afterwards.
+	 * @param pin Receives the handle that locks the file, see HashPinned().
+	 */
+	static bool VerifyPinned(const std::wstring &path,
+				 const std::string &expected,
+				 std::string &actual, HANDLE &pin);
+};
@@ -0,0 +1,211 @@
+// Keeps averaged launch times of programs to schedule the slowest first
+#include "launch-history.hpp"
+#include "launch-plan.hpp"
+#include "constants.hpp"
+#include "host.hpp"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QString>
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <mutex>
+
+namespace {
+
+struct Timing {
+	double spawnMs = 0.0;
+	double readyMs = 0.0;
+};
+
+std::mutex historyMutex;
+bool loaded = false;
+bool dirty = false;
+std::map<QString, Timing> timings; ///< Keyed by lowercase path, guarded by historyMutex
+
+QString HistoryPath()
+{
+	return QString::fromStdString(Host::ConfigPath("launch-history.json"));
+}
+
+QString Key(const std::wstring &path)
+{
+	// Paths on Windows compare case-insensitively
+	return QString::fromStdWString(path).toLower();
+}
+
+/**
+ * @brief Reads the history file on first use. Requires historyMutex.
+ */
+void EnsureLoaded()
+{
+	if (loaded)
+		return;
+	loaded = true;
+
+	QFile file(HistoryPath());
+	if (!file.open(QIODevice::ReadOnly))
+		return;
+
+	QJsonObject json = QJsonDocument::fromJson(file.readAll()).object();
+	for (auto it = json.begin(); it != json.end(); ++it) {
+		QJsonObject obj = it.value().toObject();
+		Timing timing;
+		timing.spawnMs = obj["spawnMs"].toDouble();
+		timing.readyMs = obj["readyMs"].toDouble();
+		timings[it.key()] = timing;
+	}
+}
+
+/**
+ * @brief Expected launch time of a program. Requires historyMutex.
+ * @return false if the program has not launched before.
+ */
+bool Lookup(const std::wstring &path, Timing &timing)
+{
+	EnsureLoaded();
+	auto it = timings.find(Key(path));
+	if (it == timings.end())
+		return false;
+
+	timing = it->second;
+	return true;
+}
+
+} // namespace
+
+void LaunchHistory::Record(const std::wstring &path, double spawnMs,
+			   double readyMs)
+{
+	std::lock_guard<std::mutex> lock(historyMutex);
+	EnsureLoaded();
+
+	auto [it, inserted] = timings.try_emplace(Key(path));
+	Timing &timing = it->second;
+	if (inserted) {
+		timing.spawnMs = spawnMs;
+		timing.readyMs = readyMs;
+	} else {
+		const double weight = Constants::LAUNCH_HISTORY_WEIGHT;
+		timing.spawnMs += weight * (spawnMs - timing.spawnMs);
+		timing.readyMs += weight * (readyMs - timing.readyMs);
+	}
+	dirty = true;
+}
+
+void LaunchHistory::Save()
+{
+	std::lock_guard<std::mutex> lock(historyMutex);
+	if (!dirty)
+		return;
+	dirty = false;
+
+	QString path = HistoryPath();
+	if (path.isEmpty())
+		return;
+
+	QJsonObject json;
+	for (const auto &[key, timing] : timings) {
+		QJsonObject obj;
+		obj["spawnMs"] = timing.spawnMs;
+		obj["readyMs"] = timing.readyMs;
+		json[key] = obj;
+	}
+
+	QDir().mkpath(QFileInfo(path).absolutePath());
+	QSaveFile file(path);
+	if (!file.open(QIODevice::WriteOnly)) {
+		Host::Log(Host::Warning, "Failed to write launch history");
+		return;
+	}
+	file.write(QJsonDocument(json).toJson(QJsonDocument::Compact));
+	file.commit();
+}
+
+std::vector<int> LaunchHistory::Order(const LoadoutPlan &plan)
+{
+	std::vector<std::pair<int, double>> expected;
+	expected.reserve(plan.programs.size());
+	{
+		std::lock_guard<std::mutex> lock(historyMutex);
+		for (int i = 0; i < (int)plan.programs.size(); i++) {
+			Timing timing;
+			double total = Lookup(plan.programs[i].fullPath, timing)
+					       ? timing.spawnMs + timing.readyMs
+					       : -1.0;
+			expected.push_back({i, total});
+		}
+	}
+
+	// Unknown programs sort last, ties keep the plan order
+	std::stable_sort(expected.begin(), expected.end(),
+			 [](const auto &a, const auto &b) {
+				 return a.second > b.second;
+			 });
+
+	std::vector<int> order;
+	order.reserve(expected.size());
+	for (const auto &entry : expected)
+		order.push_back(entry.first);
+	return order;
+}
+
+std::vector<LaunchHistory::Prediction>
+LaunchHistory::Predict(const LoadoutPlan &plan, int maxParallel)
+{
+	std::vector<int> order = Order(plan);
+	std::vector<Prediction> predictions;
+	predictions.reserve(order.size());
+
+	// Each lane is free again once its spawn call has returned
+	std::vector<double> lanes(std::max(1, maxParallel), 0.0);
+	std::lock_guard<std::mutex> lock(historyMutex);
+	for (int index : order) {
+		Timing timing;
+		bool known = Lookup(plan.programs[index].fullPath, timing);
+		auto lane = std::min_element(lanes.begin(), lanes.end());
+		double startMs = *lane;
+		*lane += timing.spawnMs;
+		predictions.push_back({index, startMs,
+				       startMs + timing.spawnMs +
+					       timing.readyMs,
+				       known});
+	}
+	return predictions;
+}
+
+std::string LaunchHistory::Report(const LoadoutPlan &plan, int maxParallel)
+{
+	std::vector<Prediction> predictions = Predict(plan, maxParallel);
+
+	char line[512];
+	snprintf(line, sizeof(line),
+		 "Predicted timeline of loadout '%s' with %d parallel launches:",
+		 plan.name.c_str(), maxParallel);
+	std::string report = line;
+
+	double totalMs = 0.0;
+	size_t unknown = 0;
+	for (const auto &prediction : predictions) {
+		snprintf(line, sizeof(line),
+			 "\n  %8.0f ms  %-32s ready at %8.0f ms%s",
+			 prediction.startMs,
+			 plan.programs[prediction.index].displayName.c_str(),
+			 prediction.readyMs,
+			 prediction.known ? "" : " (no history)");
+		report += line;
+		totalMs = std::max(totalMs, prediction.readyMs);
+		if (!prediction.known)
+			unknown++;
+	}
+
+	snprintf(line, sizeof(line),
+		 "\n  Loadout ready after %.0f ms, %zu programs without history",
+		 totalMs, unknown);
+	report += line;
+	return report;
+}
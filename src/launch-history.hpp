@@ -0,0 +1,59 @@
+#pragma once
+#include <string>
+#include <vector>
+
+struct LoadoutPlan;
+
+/**
+ * @brief Remembers how long programs took to launch in previous runs.
+ *
+ * For every program the time spent spawning it and the time from spawn
+ * until it was ready for input are kept as exponentially weighted averages
+ * in a small file in the plugin config folder. Launches use them to start
+ * the slowest programs first, so they do not become the long pole.
+ */
+class LaunchHistory {
+public:
+	/**
+	 * @brief Predicted launch of a single program, in ms from the start of the job.
+	 */
+	struct Prediction {
+		int index;      ///< Index of the program within the plan
+		double startMs; ///< When the program is spawned
+		double readyMs; ///< When the program is ready for input
+		bool known;     ///< Whether the program has launched before
+	};
+
+	/**
+	 * @brief Adds a measured launch to the averages of a program.
+	 * @param path Resolved absolute path of the program.
+	 * @param spawnMs Time spent spawning the program.
+	 * @param readyMs Time from spawn until the program was ready for input.
+	 */
+	static void Record(const std::wstring &path, double spawnMs,
+			   double readyMs);
+
+	/**
+	 * @brief Writes the averages if they changed since the last call.
+	 */
+	static void Save();
+
+	/**
+	 * @brief Orders the programs of a plan longest expected launch first.
+	 * Programs without history keep their plan order after the known ones.
+	 * @return Indices into the plan.
+	 */
+	static std::vector<int> Order(const LoadoutPlan &plan);
+
+	/**
+	 * @brief Simulates a launch of the plan with a fixed number of parallel spawns.
+	 * @return One prediction per program, in launch order.
+	 */
+	static std::vector<Prediction> Predict(const LoadoutPlan &plan,
+					       int maxParallel);
+
+	/**
+	 * @brief Formats the predicted timeline of a plan for the log.
+	 */
+	static std::string Report(const LoadoutPlan &plan, int maxParallel);
+};
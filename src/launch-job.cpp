@@ -0,0 +1,256 @@
+#include "launch-job.hpp"
+#include "autostart.hpp"
+#include "trace.hpp"
+#include "config.hpp"
+#include "spawn-throttle.hpp"
+#include "frame-stats.hpp"
+#include "launch-history.hpp"
+#include "constants.hpp"
+#include <QThreadPool>
+#include "host.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+
+namespace {
+
+/// Set by LaunchJob::Shutdown(), stops spawning and ends the ready waits
+std::atomic<bool> cancelled{false};
+
+std::mutex workersMutex; ///< Guards the state below
+std::condition_variable jobsDone;
+int runningJobs = 0;
+/// Workers still waiting for their program to get ready after their job
+/// finished, and the IDs of those that are done and can be joined
+std::vector<std::thread> waiters;
+std::vector<std::thread::id> finishedWaiters;
+
+/**
+ * @brief Keeps the workers of a finished job until they are done, and joins
+ * those of earlier jobs that already are.
+ */
+void KeepWaiters(std::vector<std::thread> &workers)
+{
+	std::vector<std::thread> done;
+	{
+		std::lock_guard<std::mutex> lock(workersMutex);
+		for (auto &worker : workers)
+			waiters.push_back(std::move(worker));
+
+		for (auto it = waiters.begin(); it != waiters.end();) {
+			auto finished = std::find(finishedWaiters.begin(),
+						  finishedWaiters.end(),
+						  it->get_id());
+			if (finished == finishedWaiters.end()) {
+				++it;
+				continue;
+			}
+			finishedWaiters.erase(finished);
+			done.push_back(std::move(*it));
+			it = waiters.erase(it);
+		}
+	}
+
+	// Done workers only have to return, this never waits long
+	for (auto &worker : done)
+		worker.join();
+}
+
+} // namespace
+
+LaunchJob::LaunchJob(std::shared_ptr<const LoadoutPlan> plan, QObject *parent)
+	: QObject(parent),
+	  loadoutPlan(std::move(plan)),
+	  alreadyRunning(loadoutPlan->programs.size(), false)
+{
+	// Copy the throttle settings while still on the owning thread
+	auto config = PluginConfig::Get().Snapshot();
+	maxParallel = config->maxParallelLaunches;
+	cpuPressureHigh = config->cpuPressureHigh;
+	memoryPressureHigh = config->memoryPressureHigh;
+}
+
+void LaunchJob::markRunning(int index)
+{
+	alreadyRunning[index] = true;
+}
+
+void LaunchJob::start()
+{
+	for (int i = 0; i < (int)loadoutPlan->programs.size(); i++)
+		emit programStatusChanged(i,
+					  alreadyRunning[i] ? Status::Running
+							    : Status::Queued,
+					  QString());
+
+	{
+		std::lock_guard<std::mutex> lock(workersMutex);
+		runningJobs++;
+	}
+	QThreadPool::globalInstance()->start([this]() { run(); });
+}
+
+void LaunchJob::Shutdown()
+{
+	cancelled = true;
+
+	std::vector<std::thread> joining;
+	{
+		std::unique_lock<std::mutex> lock(workersMutex);
+		jobsDone.wait(lock, []() { return runningJobs == 0; });
+		joining.swap(waiters);
+		finishedWaiters.clear();
+	}
+	for (auto &worker : joining)
+		worker.join();
+	LaunchHistory::Save();
+}
+
+bool LaunchJob::launch(int index)
+{
+	const auto &program = loadoutPlan->programs[index];
+	emit programStatusChanged(index, Status::Spawning, QString());
+
+	unsigned long errorCode = 0;
+	bool launched =
+		AutoStarter::LaunchProgram(loadoutPlan, index, errorCode);
+
+	// Log frame health next to each launch to show its impact on OBS
+	FrameStats frames = FrameStats::Sample();
+	Host::Log(Host::Info,
+		  "Launch of '%s' %s (lagged %u, skipped %u, dropped %lld frames)",
+		  program.displayName.c_str(), launched ? "done" : "failed",
+		  frames.laggedFrames, frames.skippedFrames,
+		  (long long)frames.droppedFrames);
+
+	if (launched) {
+		Trace::AddInstant("spawned", "launch",
+				  program.displayName.c_str());
+		emit programStatusChanged(index, Status::Running, QString());
+		return true;
+	}
+
+	Host::Log(Host::Warning, "Failed to launch program: %ls",
+		  program.fullPath.c_str());
+	emit programStatusChanged(index, Status::Failed,
+				  QString("Error code %1").arg(errorCode));
+	return false;
+}
+
+void LaunchJob::AwaitReady(const std::shared_ptr<const LoadoutPlan> &plan,
+			   int index, uint64_t spawnStartNs,
+			   uint64_t spawnEndNs)
+{
+	const auto &program = plan->programs[index];
+	double readyMs = 0.0;
+	switch (AutoStarter::WaitUntilReady(plan, (size_t)index,
+					    Constants::READY_TIMEOUT_MS,
+					    cancelled)) {
+	case AutoStarter::Readiness::Ready:
+		Trace::AddInstant("input idle", "launch",
+				  program.displayName.c_str());
+		readyMs = (double)(Trace::Now() - spawnEndNs) / 1000000.0;
+		break;
+	case AutoStarter::Readiness::TimedOut:
+		// Slow starters still go first next time
+		readyMs = (double)Constants::READY_TIMEOUT_MS;
+		break;
+	case AutoStarter::Readiness::Cancelled:
+	case AutoStarter::Readiness::Untracked:
+		return;
+	}
+
+	LaunchHistory::Record(program.fullPath,
+			      (double)(spawnEndNs - spawnStartNs) / 1000000.0,
+			      readyMs);
+}
+
+void LaunchJob::run()
+{
+	TraceSpan span("LaunchJob", "launch", loadoutPlan->name.c_str());
+
+	// Spawn concurrently, as many at once as current system pressure allows
+	SpawnThrottle throttle(maxParallel, cpuPressureHigh,
+			       memoryPressureHigh);
+	std::mutex mutex;
+	std::condition_variable spawnDone;
+	int inFlight = 0;
+	size_t spawned = 0;
+	std::atomic<bool> success{true};
+	std::vector<std::thread> workers;
+	workers.reserve(loadoutPlan->programs.size());
+	// The last ready wait of the job saves the history
+	auto unsaved = std::make_shared<std::atomic<int>>(0);
+
+	// Start the programs that took longest in earlier runs first
+	for (int i : LaunchHistory::Order(*loadoutPlan)) {
+		if (alreadyRunning[i])
+			continue;
+
+		// Sample again before every spawn, a free slot alone does not
+		// mean the previous spawns left OBS alone
+		std::unique_lock<std::mutex> lock(mutex);
+		while (!cancelled && inFlight >= throttle.Update()) {
+			spawnDone.wait_for(lock,
+					   std::chrono::milliseconds(100));
+		}
+		// OBS is unloading, leave the remaining programs alone
+		if (cancelled) {
+			success = false;
+			break;
+		}
+		inFlight++;
+		lock.unlock();
+
+		(*unsaved)++;
+		workers.emplace_back([&, i, plan = loadoutPlan, unsaved]() {
+			uint64_t spawnStartNs = Trace::Now();
+			bool launched = launch(i);
+			uint64_t spawnEndNs = Trace::Now();
+			if (!launched)
+				success = false;
+
+			// Warming up no longer counts against the spawn limit.
+			// The job may finish right after, so nothing of it is
+			// touched past this point.
+			{
+				std::lock_guard<std::mutex> doneLock(mutex);
+				inFlight--;
+				spawned++;
+				spawnDone.notify_one();
+			}
+
+			if (launched)
+				AwaitReady(plan, i, spawnStartNs, spawnEndNs);
+			if (--*unsaved == 0)
+				LaunchHistory::Save();
+
+			std::lock_guard<std::mutex> workersLock(workersMutex);
+			finishedWaiters.push_back(std::this_thread::get_id());
+		});
+	}
+
+	// Finish once everything is spawned, readiness is only recorded
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		spawnDone.wait(lock,
+			       [&]() { return spawned == workers.size(); });
+	}
+	KeepWaiters(workers);
+
+	// Finish on the owning thread so the job is never deleted while the
+	// worker still touches it
+	QMetaObject::invokeMethod(
+		this,
+		[this, success = success.load()]() {
+			emit finished(success);
+			deleteLater();
+		},
+		Qt::QueuedConnection);
+
+	std::lock_guard<std::mutex> lock(workersMutex);
+	runningJobs--;
+	jobsDone.notify_all();
+}
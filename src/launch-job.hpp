@@ -0,0 +1,103 @@
+#pragma once
+#include <QObject>
+#include <QString>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "launch-plan.hpp"
+
+/**
+ * @brief Launches a compiled loadout on a worker thread.
+ *
+ * Programs are spawned concurrently, throttled by SpawnThrottle, and those
+ * that took longest in earlier runs are started first. Status
+ * changes are emitted per program as they happen, so the UI can show
+ * progress without blocking. The job deletes itself after emitting
+ * finished(), which is always delivered on the thread that owns the job.
+ * Waits for launched programs to get ready outlive the job, they only feed
+ * LaunchHistory and are ended by Shutdown().
+ */
+class LaunchJob : public QObject {
+	Q_OBJECT
+public:
+	/**
+	 * @brief Launch state of a single program within the job.
+	 */
+	enum class Status {
+		Queued,   ///< Waiting for its turn
+		Spawning, ///< Launch is in progress
+		Running,  ///< Program is running
+		Failed    ///< Program could not be launched
+	};
+	Q_ENUM(Status)
+
+	/**
+	 * @brief Creates a job for the given plan. Call start() to run it.
+	 * @param plan Compiled loadout to launch.
+	 * @param parent Parent object pointer.
+	 */
+	explicit LaunchJob(std::shared_ptr<const LoadoutPlan> plan,
+			   QObject *parent = nullptr);
+
+	/**
+	 * @brief Returns the plan this job launches.
+	 */
+	const LoadoutPlan &plan() const { return *loadoutPlan; }
+
+	/**
+	 * @brief Reports a program as running instead of launching it.
+	 * Must be called before start().
+	 * @param index Index of the program within the plan.
+	 */
+	void markRunning(int index);
+
+	/**
+	 * @brief Starts launching on the global thread pool.
+	 */
+	void start();
+
+	/**
+	 * @brief Stops spawning for all jobs, cancels the ready waits and
+	 * joins their workers. Call before the plugin is unloaded.
+	 */
+	static void Shutdown();
+
+signals:
+	/**
+	 * @brief Emitted whenever a program changes state.
+	 * @param index Index of the program within the plan.
+	 * @param status New status of the program.
+	 * @param reason Failure reason, empty unless status is Failed.
+	 */
+	void programStatusChanged(int index, LaunchJob::Status status,
+				  const QString &reason);
+
+	/**
+	 * @brief Emitted once after every program has been spawned or failed,
+	 * without waiting for the programs to get ready.
+	 * @param success true if every program is running.
+	 */
+	void finished(bool success);
+
+private:
+	std::shared_ptr<const LoadoutPlan> loadoutPlan;
+	std::vector<bool> alreadyRunning;
+	int maxParallel;
+	double cpuPressureHigh;
+	double memoryPressureHigh;
+
+	void run();
+	/**
+	 * @brief Launches one program and reports its status.
+	 * @return true if the program is running.
+	 */
+	bool launch(int index);
+	/**
+	 * @brief Waits for a launched program to become ready and records
+	 * its timing in LaunchHistory. Programs that do not get ready in time
+	 * are recorded with the timeout. Runs after the job is gone.
+	 */
+	static void AwaitReady(const std::shared_ptr<const LoadoutPlan> &plan,
+			       int index, uint64_t spawnStartNs,
+			       uint64_t spawnEndNs);
+};
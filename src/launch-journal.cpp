@@ -0,0 +1,342 @@
+// Keeps a state file of launched processes for recovery after a crash
+#include <windows.h>
+#include "launch-journal.hpp"
+#include "launch-plan.hpp"
+#include "constants.hpp"
+#include "host.hpp"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+/**
+ * @brief An entry as stored in the file, with the instance that recorded it.
+ */
+struct StoredEntry {
+	LaunchJournal::Entry entry;
+	unsigned long owner = 0;     ///< Process ID of the recording instance
+	uint64_t ownerStartTime = 0; ///< Guards against a reused owner ID
+};
+
+/**
+ * @brief A change not yet merged into the file.
+ */
+struct Change {
+	enum Kind { Record, Remove, Clear } kind;
+	LaunchJournal::Entry entry; ///< Only the process ID is used by Remove
+	/// Set for programs recorded from their plan, fills the path and
+	/// loadout of entry when the change is merged
+	std::shared_ptr<const LoadoutPlan> loadout;
+	size_t index = 0;
+};
+
+std::mutex journalMutex;
+std::condition_variable changed;
+std::vector<Change> pending; ///< Guarded by journalMutex
+bool stopRequested = false;  ///< Guarded by journalMutex
+std::thread writerThread;
+
+HANDLE fileMutex = nullptr; ///< Serializes merges of all instances
+unsigned long instanceId = 0;
+uint64_t instanceStartTime = 0;
+
+QString JournalPath()
+{
+	return QString::fromStdString(Host::ConfigPath("launch-journal.json"));
+}
+
+uint64_t ProcessStartTime(HANDLE process)
+{
+	FILETIME creation, exit, kernel, user;
+	if (!GetProcessTimes(process, &creation, &exit, &kernel, &user))
+		return 0;
+	return ((uint64_t)creation.dwHighDateTime << 32) |
+	       creation.dwLowDateTime;
+}
+
+bool IsInstanceAlive(unsigned long processId, uint64_t startTime)
+{
+	if (processId == instanceId)
+		return true;
+
+	HANDLE process = OpenProcess(
+		SYNCHRONIZE | PROCESS_QUERY_LIMITED_INFORMATION, FALSE,
+		processId);
+	if (!process)
+		return false;
+
+	bool alive = WaitForSingleObject(process, 0) == WAIT_TIMEOUT &&
+		     ProcessStartTime(process) == startTime;
+	CloseHandle(process);
+	return alive;
+}
+
+/**
+ * @brief Locks the file against the other instances of the session.
+ * @return false if the lock could not be taken, the file is used unlocked.
+ */
+bool LockFile()
+{
+	if (!fileMutex) {
+		instanceId = GetCurrentProcessId();
+		instanceStartTime = ProcessStartTime(GetCurrentProcess());
+		fileMutex = CreateMutexW(nullptr, FALSE,
+					 L"Local\\AutostarterLaunchJournal");
+	}
+	if (!fileMutex)
+		return false;
+
+	// An instance that died holding the lock abandons it
+	DWORD result = WaitForSingleObject(fileMutex, 5000);
+	return result == WAIT_OBJECT_0 || result == WAIT_ABANDONED;
+}
+
+void UnlockFile(bool locked)
+{
+	if (locked)
+		ReleaseMutex(fileMutex);
+}
+
+std::vector<StoredEntry> ReadEntries()
+{
+	std::vector<StoredEntry> result;
+	QFile file(JournalPath());
+	if (!file.open(QIODevice::ReadOnly))
+		return result;
+
+	QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+	for (const auto &value : doc.array()) {
+		QJsonObject obj = value.toObject();
+		StoredEntry stored;
+		LaunchJournal::Entry &entry = stored.entry;
+		entry.processId = (unsigned long)obj["pid"].toInteger();
+		entry.startTime = obj["startTime"].toString().toULongLong();
+		entry.path = obj["path"].toString().toStdWString();
+		entry.loadout = obj["loadout"].toString().toStdString();
+		stored.owner = (unsigned long)obj["owner"].toInteger();
+		stored.ownerStartTime =
+			obj["ownerStartTime"].toString().toULongLong();
+		if (entry.processId != 0 && entry.startTime != 0)
+			result.push_back(std::move(stored));
+	}
+	return result;
+}
+
+/**
+ * @brief Replaces the state file with the given entries. The file is
+ * written to a temporary file first, so a crash never leaves it truncated.
+ */
+void WriteEntries(const std::vector<StoredEntry> &entries)
+{
+	QString path = JournalPath();
+	if (path.isEmpty())
+		return;
+
+	if (entries.empty()) {
+		QFile::remove(path);
+		return;
+	}
+
+	QJsonArray array;
+	for (const auto &stored : entries) {
+		QJsonObject obj;
+		obj["pid"] = (qint64)stored.entry.processId;
+		// Stored as a string, JSON numbers cannot hold 64 bit exactly
+		obj["startTime"] = QString::number(stored.entry.startTime);
+		obj["path"] = QString::fromStdWString(stored.entry.path);
+		obj["loadout"] = QString::fromStdString(stored.entry.loadout);
+		obj["owner"] = (qint64)stored.owner;
+		obj["ownerStartTime"] = QString::number(stored.ownerStartTime);
+		array.append(obj);
+	}
+
+	QDir().mkpath(QFileInfo(path).absolutePath());
+	QSaveFile file(path);
+	if (!file.open(QIODevice::WriteOnly)) {
+		Host::Log(Host::Warning, "Failed to write launch journal");
+		return;
+	}
+	file.write(QJsonDocument(array).toJson(QJsonDocument::Compact));
+	file.commit();
+}
+
+void RemoveProcess(std::vector<StoredEntry> &entries, unsigned long processId)
+{
+	entries.erase(std::remove_if(entries.begin(), entries.end(),
+				     [processId](const StoredEntry &stored) {
+					     return stored.entry.processId ==
+						    processId;
+				     }),
+		      entries.end());
+}
+
+/**
+ * @brief Applies changes to the file as it is now, keeping the entries
+ * other instances recorded in the meantime.
+ */
+void Merge(const std::vector<Change> &changes)
+{
+	if (changes.empty())
+		return;
+
+	bool locked = LockFile();
+	std::vector<StoredEntry> entries = ReadEntries();
+	for (const auto &change : changes) {
+		switch (change.kind) {
+		case Change::Record:
+			RemoveProcess(entries, change.entry.processId);
+			entries.push_back(
+				{change.entry, instanceId, instanceStartTime});
+			if (change.loadout) {
+				LaunchJournal::Entry &entry =
+					entries.back().entry;
+				entry.path = change.loadout->programs[change.index]
+						     .fullPath;
+				entry.loadout = change.loadout->name;
+			}
+			break;
+		case Change::Remove:
+			RemoveProcess(entries, change.entry.processId);
+			break;
+		case Change::Clear:
+			entries.erase(std::remove_if(entries.begin(),
+						     entries.end(),
+						     [](const StoredEntry &stored) {
+							     return stored.owner ==
+								    instanceId;
+						     }),
+				      entries.end());
+			break;
+		}
+	}
+	WriteEntries(entries);
+	UnlockFile(locked);
+}
+
+/**
+ * @brief Merges the pending changes in batches, a launch of several
+ * programs ends up as a single write.
+ */
+void WriteLoop()
+{
+	// Swapped with pending, so both keep their capacity and queueing a
+	// change does not allocate once the journal is warmed up
+	std::vector<Change> batch;
+	std::unique_lock<std::mutex> lock(journalMutex);
+	while (!stopRequested) {
+		changed.wait(lock,
+			     [] { return stopRequested || !pending.empty(); });
+		changed.wait_for(
+			lock,
+			std::chrono::milliseconds(
+				Constants::JOURNAL_WRITE_DELAY_MS),
+			[] { return stopRequested; });
+
+		batch.swap(pending);
+		lock.unlock();
+		Merge(batch);
+		batch.clear();
+		lock.lock();
+	}
+}
+
+void Enqueue(Change change)
+{
+	std::lock_guard<std::mutex> lock(journalMutex);
+	pending.push_back(std::move(change));
+	if (!writerThread.joinable()) {
+		stopRequested = false;
+		writerThread = std::thread(WriteLoop);
+	}
+	changed.notify_one();
+}
+
+} // namespace
+
+std::vector<LaunchJournal::Entry> LaunchJournal::Load()
+{
+	bool locked = LockFile();
+	std::vector<StoredEntry> stored = ReadEntries();
+	UnlockFile(locked);
+
+	// Entries of running instances stay with them
+	std::vector<Entry> result;
+	for (auto &entry : stored) {
+		if (!IsInstanceAlive(entry.owner, entry.ownerStartTime))
+			result.push_back(std::move(entry.entry));
+	}
+	return result;
+}
+
+std::vector<LaunchJournal::Entry> LaunchJournal::LoadAll()
+{
+	bool locked = LockFile();
+	std::vector<StoredEntry> stored = ReadEntries();
+	UnlockFile(locked);
+
+	std::vector<Entry> result;
+	for (auto &entry : stored) {
+		entry.entry.ownerRunning =
+			IsInstanceAlive(entry.owner, entry.ownerStartTime);
+		result.push_back(std::move(entry.entry));
+	}
+	return result;
+}
+
+void LaunchJournal::Record(const Entry &entry)
+{
+	Enqueue({Change::Record, entry});
+}
+
+void LaunchJournal::Record(unsigned long processId, uint64_t startTime,
+			   const std::shared_ptr<const LoadoutPlan> &loadout,
+			   size_t index)
+{
+	Change change = {Change::Record, Entry()};
+	change.entry.processId = processId;
+	change.entry.startTime = startTime;
+	change.loadout = loadout;
+	change.index = index;
+	Enqueue(std::move(change));
+}
+
+void LaunchJournal::Remove(unsigned long processId)
+{
+	Entry entry;
+	entry.processId = processId;
+	Enqueue({Change::Remove, entry});
+}
+
+void LaunchJournal::Clear()
+{
+	Enqueue({Change::Clear, Entry()});
+}
+
+void LaunchJournal::Flush()
+{
+	{
+		std::lock_guard<std::mutex> lock(journalMutex);
+		stopRequested = true;
+	}
+	changed.notify_one();
+	if (writerThread.joinable())
+		writerThread.join();
+
+	// The thread may have stopped with changes left
+	std::vector<Change> batch;
+	{
+		std::lock_guard<std::mutex> lock(journalMutex);
+		batch.swap(pending);
+	}
+	Merge(batch);
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct LoadoutPlan;
+
+/**
+ * @brief Persistent record of the programs launched in this session.
+ *
+ * Every spawned process is written to a small state file in the plugin
+ * config folder, so that the programs can be found again after OBS crashed.
+ * The process start time is stored next to the process ID, which keeps a
+ * reused ID from being mistaken for the original program.
+ *
+ * All OBS instances and CLI runs of a session share the file. Each entry
+ * names the instance that recorded it, and changes are merged into the
+ * file as it is under a named mutex. Changes are queued and written by a
+ * background thread in batches, so launching never waits for the disk.
+ */
+class LaunchJournal {
+public:
+	/**
+	 * @brief A single launched process.
+	 */
+	struct Entry {
+		unsigned long processId = 0; ///< Process ID at launch
+		uint64_t startTime = 0;      ///< Process creation time as FILETIME ticks
+		std::wstring path;           ///< Resolved absolute path of the program
+		std::string loadout;         ///< Name of the loadout it was launched from
+		bool ownerRunning = false;   ///< Recorded by an instance that still runs, only set by LoadAll()
+	};
+
+	/**
+	 * @brief Reads the entries left over by instances that no longer run.
+	 * Entries of running instances are never returned.
+	 * @return The entries, empty if the file does not exist.
+	 */
+	static std::vector<Entry> Load();
+
+	/**
+	 * @brief Reads every entry, including those of running instances,
+	 * which are flagged with ownerRunning. Leaves the file untouched, e.g.
+	 * for status queries.
+	 */
+	static std::vector<Entry> LoadAll();
+
+	/**
+	 * @brief Adds a launched process, or takes it over from the instance
+	 * that recorded it before.
+	 * @param entry The process to record.
+	 */
+	static void Record(const Entry &entry);
+
+	/**
+	 * @brief Like Record(const Entry &), for a program launched from its
+	 * compiled plan. Only the plan is shared with the writer thread, which
+	 * builds the entry, so recording does not copy the path or name.
+	 * @param processId Process ID at launch.
+	 * @param startTime Process creation time as FILETIME ticks.
+	 * @param loadout Compiled loadout the program belongs to.
+	 * @param index Index of the program within the loadout.
+	 */
+	static void Record(unsigned long processId, uint64_t startTime,
+			   const std::shared_ptr<const LoadoutPlan> &loadout,
+			   size_t index);
+
+	/**
+	 * @brief Removes a process.
+	 * @param processId ID of the process to remove.
+	 */
+	static void Remove(unsigned long processId);
+
+	/**
+	 * @brief Removes all processes this instance recorded.
+	 */
+	static void Clear();
+
+	/**
+	 * @brief Writes the queued changes and stops the writer thread.
+	 * Call before the host exits, a later change starts it again.
+	 */
+	static void Flush();
+};
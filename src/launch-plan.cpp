@@ -0,0 +1,206 @@
+// Compiles loadouts into immutable launch plans
+#include <windows.h>
+#include "launch-plan.hpp"
+#include "path-index.hpp"
+#include <QDir>
+#include <QFileInfo>
+#include <QString>
+#include "host.hpp"
+#include <algorithm>
+#include <cwchar>
+#include <cwctype>
+#include <map>
+#include <set>
+
+namespace {
+
+struct CaseInsensitiveLess {
+	bool operator()(const std::wstring &a, const std::wstring &b) const
+	{
+		return _wcsicmp(a.c_str(), b.c_str()) < 0;
+	}
+};
+
+std::wstring ToWide(const std::string &value)
+{
+	return QString::fromStdString(value).toStdWString();
+}
+
+/**
+ * @brief Builds a Unicode environment block from the current environment
+ * with the given overrides applied. An empty override value removes the
+ * variable. Returns an empty block if there is nothing to override.
+ */
+std::vector<wchar_t>
+BuildEnvironment(const std::map<std::string, std::string> &overrides)
+{
+	std::vector<wchar_t> block;
+	if (overrides.empty())
+		return block;
+
+	// Windows expects the block sorted by name, case-insensitively
+	std::map<std::wstring, std::wstring, CaseInsensitiveLess> vars;
+	if (LPWCH parent = GetEnvironmentStringsW()) {
+		for (LPCWSTR entry = parent; *entry;
+		     entry += wcslen(entry) + 1) {
+			// Skip the first character so hidden "=C:" entries parse
+			const wchar_t *separator = wcschr(entry + 1, L'=');
+			if (!separator)
+				continue;
+			vars[std::wstring(entry, separator)] = separator + 1;
+		}
+		FreeEnvironmentStringsW(parent);
+	}
+
+	for (const auto &[name, value] : overrides) {
+		if (value.empty())
+			vars.erase(ToWide(name));
+		else
+			vars[ToWide(name)] = ToWide(value);
+	}
+
+	for (const auto &[name, value] : vars) {
+		block.insert(block.end(), name.begin(), name.end());
+		block.push_back(L'=');
+		block.insert(block.end(), value.begin(), value.end());
+		block.push_back(L'\0');
+	}
+	block.push_back(L'\0');
+	return block;
+}
+
+/**
+ * @brief Fills in everything that depends on the resolved path.
+ */
+void Locate(LaunchPlan &plan, const std::wstring &fullPath)
+{
+	plan.fullPath = fullPath;
+	QFileInfo fileInfo(QString::fromStdWString(plan.fullPath));
+	plan.imageName = fileInfo.fileName().toStdWString();
+	// Unresolved commands start in the current directory
+	plan.workingDirectory.clear();
+	if (fileInfo.isAbsolute())
+		plan.workingDirectory =
+			QDir::toNativeSeparators(fileInfo.absolutePath())
+				.toStdWString();
+
+	// Check if the program is a exe or a file to open
+	QString suffix = fileInfo.suffix();
+	plan.method = !suffix.isEmpty() &&
+				      suffix.compare("exe", Qt::CaseInsensitive) != 0
+			      ? LaunchMethod::ShellOpen
+			      : LaunchMethod::Spawn;
+
+	plan.commandLine.clear();
+	if (plan.method == LaunchMethod::Spawn) {
+		std::wstring commandLine = L"\"" + plan.fullPath + L"\"";
+		if (!plan.parameters.empty())
+			commandLine += L" " + plan.parameters;
+		plan.commandLine.assign(commandLine.begin(), commandLine.end());
+		plan.commandLine.push_back(L'\0');
+	}
+}
+
+LaunchPlan CompileProgram(const Program &program)
+{
+	LaunchPlan plan;
+	plan.displayName = program.executable;
+	plan.minimized = program.minimized;
+	plan.captureOutput = program.captureOutput;
+	plan.sha256 = program.sha256;
+	plan.parameters = ToWide(program.arguments);
+	if (program.path.empty()) {
+		// Lowercase like the PATH index, so launches look it up as is
+		plan.command = ToWide(program.executable);
+		std::transform(plan.command.begin(), plan.command.end(),
+			       plan.command.begin(),
+			       [](wchar_t c) { return (wchar_t)towlower(c); });
+	}
+
+	Locate(plan, ResolveProgramPath(program));
+	// Built for documents too, a relocated command may be an executable
+	plan.environment = BuildEnvironment(program.environment);
+	return plan;
+}
+
+/**
+ * @brief Appends the programs of a loadout and, depth first, those of its
+ * includes, skipping programs that are already part of the plan.
+ */
+void Flatten(const Loadout &loadout, const ConfigData &config,
+	     std::vector<const Loadout *> &stack, LoadoutPlan &plan,
+	     std::set<std::wstring, CaseInsensitiveLess> &seen)
+{
+	stack.push_back(&loadout);
+	for (const auto &program : loadout.programs) {
+		LaunchPlan compiled = CompileProgram(program);
+		if (seen.insert(compiled.fullPath).second)
+			plan.programs.push_back(std::move(compiled));
+	}
+
+	for (const auto &name : loadout.includes) {
+		const Loadout *include = config.GetLoadout(name);
+		if (!include) {
+			Host::Log(Host::Warning,
+				  "Loadout '%s' includes missing loadout '%s'",
+				  loadout.name.c_str(), name.c_str());
+			continue;
+		}
+		if (std::find(stack.begin(), stack.end(), include) !=
+		    stack.end()) {
+			Host::Log(Host::Warning,
+				  "Loadout '%s' includes '%s' in a cycle, skipping it",
+				  loadout.name.c_str(), name.c_str());
+			continue;
+		}
+		Flatten(*include, config, stack, plan, seen);
+	}
+	stack.pop_back();
+}
+
+} // namespace
+
+std::wstring ResolveProgramPath(const Program &program)
+{
+	if (program.path.empty()) {
+		std::wstring fullPath;
+		if (PathIndex::Resolve(ToWide(program.executable), fullPath))
+			return fullPath;
+		return ToWide(program.executable);
+	}
+
+	QFileInfo fileInfo(QString::fromStdString(program.path + "/" +
+						  program.executable));
+	return QDir::toNativeSeparators(fileInfo.absoluteFilePath())
+		.toStdWString();
+}
+
+bool RelocateCommand(const LaunchPlan &plan, LaunchPlan &relocated)
+{
+	// Only a command that moved allocates
+	if (plan.command.empty() ||
+	    PathIndex::IsCurrent(plan.command, plan.fullPath))
+		return false;
+
+	std::wstring fullPath;
+	if (!PathIndex::Resolve(plan.command, fullPath) ||
+	    _wcsicmp(fullPath.c_str(), plan.fullPath.c_str()) == 0)
+		return false;
+
+	relocated = plan;
+	Locate(relocated, fullPath);
+	return true;
+}
+
+std::shared_ptr<const LoadoutPlan> LoadoutPlan::Compile(const Loadout &loadout,
+							const ConfigData &config)
+{
+	auto plan = std::make_shared<LoadoutPlan>();
+	plan->name = loadout.name;
+	plan->programs.reserve(loadout.programs.size());
+
+	std::vector<const Loadout *> stack;
+	std::set<std::wstring, CaseInsensitiveLess> seen;
+	Flatten(loadout, config, stack, *plan, seen);
+	return plan;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "config.hpp"
+
+/**
+ * @brief How a compiled program entry is started.
+ */
+enum class LaunchMethod {
+	Spawn,    ///< Executable started directly via CreateProcessW
+	ShellOpen ///< Document opened through its registered handler
+};
+
+/**
+ * @brief Immutable, precompiled launch instructions for a single program.
+ *
+ * Everything the launcher needs is resolved once when the loadout is
+ * compiled, so starting the program does not allocate.
+ */
+struct LaunchPlan {
+	std::string displayName;       ///< Executable name used for logging
+	std::wstring imageName;        ///< Executable name matched against running processes
+	std::wstring fullPath;         ///< Resolved absolute path of the program
+	std::wstring workingDirectory; ///< Directory the program is started in
+	std::wstring parameters;       ///< Raw argument string passed to the program
+	std::vector<wchar_t> environment; ///< Prebuilt environment block, empty to inherit
+	LaunchMethod method = LaunchMethod::Spawn;
+	bool minimized = false;
+	bool captureOutput = false; ///< Redirect stdout and stderr into a log file
+	std::string sha256;         ///< Pinned digest verified before launch, empty if not pinned
+	std::wstring command;       ///< Bare command in lowercase, looked up on the PATH again at launch, empty for paths
+
+	/**
+	 * @brief Prebuilt, terminated command line.
+	 *
+	 * Plans are shared between threads and CreateProcessW may modify its
+	 * command line argument, so launches copy this into a buffer of their
+	 * own first.
+	 */
+	std::vector<wchar_t> commandLine;
+};
+
+/**
+ * @brief Resolves the absolute path a program is started from.
+ *
+ * Programs without a directory are bare command names and are looked up on
+ * the PATH. If the command cannot be found, the name is returned unchanged.
+ * @param program The configured program.
+ * @return The native absolute path of the program.
+ */
+std::wstring ResolveProgramPath(const Program &program);
+
+/**
+ * @brief Looks a bare command up on the PATH again before it is launched.
+ *
+ * Plans are compiled once, but commands may be installed, removed or
+ * shadowed on the PATH afterwards.
+ * @param plan The compiled program.
+ * @param relocated Receives a copy of the plan for the current location.
+ * Only filled, and only allocating, when the command moved.
+ * @return true if the command now resolves to another file and relocated
+ * must be launched instead of plan.
+ */
+bool RelocateCommand(const LaunchPlan &plan, LaunchPlan &relocated);
+
+/**
+ * @brief Compiled form of a loadout, rebuilt whenever the loadout or one of
+ * its included loadouts changes.
+ */
+struct LoadoutPlan {
+	std::string name;                 ///< Name of the source loadout
+	std::vector<LaunchPlan> programs; ///< Own programs first, then those of included loadouts
+
+	/**
+	 * @brief Compiles a loadout and its includes into a flat launch plan.
+	 *
+	 * Programs that appear more than once are only launched for their
+	 * first occurrence. Includes that are missing or form a cycle are
+	 * skipped with a warning.
+	 * @param loadout The loadout to compile.
+	 * @param config The configuration the included loadouts are taken from.
+	 * @return Shared pointer to the compiled plan.
+	 */
+	static std::shared_ptr<const LoadoutPlan> Compile(const Loadout &loadout,
+							  const ConfigData &config);
+};
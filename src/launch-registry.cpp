@@ -0,0 +1,474 @@
+// Shares launched programs between OBS instances through shared memory
+#include <windows.h>
+#include "launch-registry.hpp"
+#include "host.hpp"
+#include <cwctype>
+#include <mutex>
+
+namespace {
+
+constexpr LONG RegistryVersion = 1;
+constexpr int EntryCount = 128;
+constexpr int OwnerCount = 16;
+constexpr ULONGLONG SpawnWaitMs = 10000;
+
+enum EntryState : LONG { Free = 0, Claimed = 1, Ready = 2 };
+
+/// Owner slot value while the last instance terminates the program
+constexpr LONG Sealed = -1;
+
+/**
+ * @brief One shared program. The key (hash and path) is written while the
+ * entry is Claimed and does not change while it is Ready. An entry returns
+ * to Free once its program was terminated, so instances check the key
+ * again after they joined it.
+ */
+struct RegistryEntry {
+	volatile LONG state;
+	volatile LONG spawner;         ///< Instance currently spawning, 0 if none
+	volatile LONG processId;       ///< Running program, 0 if never spawned
+	volatile LONG64 processStart;  ///< Creation time, guards against PID reuse
+	volatile LONG owners[OwnerCount]; ///< Process IDs of the instances using the program
+	uint64_t pathHash;
+	wchar_t path[MAX_PATH];
+};
+
+struct RegistryTable {
+	volatile LONG version;
+	RegistryEntry entries[EntryCount];
+};
+
+HANDLE mapping = nullptr;
+RegistryTable *table = nullptr;
+LONG instanceId = 0;
+
+/// Tracked processes of this instance per entry, all share one owner slot
+std::mutex useMutex;
+int uses[EntryCount] = {};
+
+uint64_t HashPath(const std::wstring &path)
+{
+	// FNV-1a over the lowercase path, paths are case-insensitive
+	uint64_t hash = 14695981039346656037ull;
+	for (wchar_t c : path) {
+		hash ^= (uint64_t)towlower(c);
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+LONG64 GetStartTime(HANDLE process)
+{
+	FILETIME creation, exit, kernel, user;
+	if (!GetProcessTimes(process, &creation, &exit, &kernel, &user))
+		return 0;
+	return ((LONG64)creation.dwHighDateTime << 32) |
+	       creation.dwLowDateTime;
+}
+
+bool IsProcessAlive(DWORD processId, LONG64 expectedStart = 0)
+{
+	if (processId == 0)
+		return false;
+
+	HANDLE process = OpenProcess(
+		SYNCHRONIZE | PROCESS_QUERY_LIMITED_INFORMATION, FALSE,
+		processId);
+	if (!process)
+		return false;
+
+	bool alive = WaitForSingleObject(process, 0) == WAIT_TIMEOUT &&
+		     (expectedStart == 0 ||
+		      GetStartTime(process) == expectedStart);
+	CloseHandle(process);
+	return alive;
+}
+
+bool Matches(const RegistryEntry &entry, const std::wstring &path,
+	     uint64_t hash)
+{
+	return entry.state == Ready && entry.pathHash == hash &&
+	       _wcsicmp(entry.path, path.c_str()) == 0;
+}
+
+int FindOrClaimEntry(const std::wstring &path, uint64_t hash)
+{
+	// Freed entries break probe sequences, so look for the key first
+	for (int probe = 0; probe < EntryCount; probe++) {
+		int index = (int)((hash + probe) % EntryCount);
+		if (Matches(table->entries[index], path, hash))
+			return index;
+	}
+
+	for (int probe = 0; probe < EntryCount; probe++) {
+		RegistryEntry &entry =
+			table->entries[(hash + probe) % EntryCount];
+
+		if (InterlockedCompareExchange(&entry.state, Claimed, Free) ==
+		    Free) {
+			entry.pathHash = hash;
+			wcsncpy(entry.path, path.c_str(), MAX_PATH - 1);
+			entry.path[MAX_PATH - 1] = L'\0';
+			InterlockedExchange(&entry.state, Ready);
+			return (int)((hash + probe) % EntryCount);
+		}
+
+		// Another instance is still writing the key of this entry
+		ULONGLONG deadline = GetTickCount64() + 1000;
+		while (entry.state == Claimed && GetTickCount64() < deadline)
+			Sleep(0);
+
+		if (Matches(entry, path, hash))
+			return (int)((hash + probe) % EntryCount);
+	}
+	return -1;
+}
+
+/**
+ * @brief Counts instances using the entry, freeing slots of dead instances.
+ */
+int CountLiveOwners(RegistryEntry &entry)
+{
+	int count = 0;
+	for (volatile LONG &owner : entry.owners) {
+		LONG processId = owner;
+		if (processId == 0 || processId == Sealed)
+			continue;
+		if (processId == instanceId || IsProcessAlive(processId))
+			count++;
+		else
+			InterlockedCompareExchange(&owner, 0, processId);
+	}
+	return count;
+}
+
+/**
+ * @brief Joins the entry, waiting while another instance terminates its
+ * program.
+ * @param waitMs Longest time to wait for the termination.
+ * @return 1 if a slot was taken, 0 if this instance already owned one, -1
+ * if all slots are used or the entry stayed sealed.
+ */
+int AddOwner(RegistryEntry &entry, ULONGLONG waitMs)
+{
+	for (volatile LONG &owner : entry.owners) {
+		if (owner == instanceId)
+			return 0;
+	}
+
+	ULONGLONG deadline = GetTickCount64() + waitMs;
+	for (int attempt = 0;; attempt++) {
+		bool sealed = false;
+		for (volatile LONG &owner : entry.owners) {
+			LONG previous = InterlockedCompareExchange(
+				&owner, instanceId, 0);
+			if (previous == 0)
+				return 1;
+			sealed = sealed || previous == Sealed;
+		}
+
+		if (sealed && GetTickCount64() < deadline) {
+			Sleep(10);
+			continue;
+		}
+		if (sealed || attempt > 0)
+			return -1;
+		// All slots taken, reclaim the ones of crashed instances
+		CountLiveOwners(entry);
+	}
+}
+
+void RemoveOwner(RegistryEntry &entry)
+{
+	for (volatile LONG &owner : entry.owners)
+		InterlockedCompareExchange(&owner, 0, instanceId);
+}
+
+void UnsealOwners(RegistryEntry &entry, int count)
+{
+	for (int i = 0; i < count; i++)
+		InterlockedExchange(&entry.owners[i], 0);
+}
+
+/**
+ * @brief Seals every owner slot unless another running instance holds one.
+ * Sealed slots cannot be taken, so no instance adopts the program while it
+ * is terminated.
+ */
+bool SealOwners(RegistryEntry &entry)
+{
+	for (int i = 0; i < OwnerCount; i++) {
+		volatile LONG &owner = entry.owners[i];
+		for (;;) {
+			LONG processId = owner;
+			// A sealed slot means another instance terminates it
+			if (processId == Sealed ||
+			    (processId != 0 && processId != instanceId &&
+			     IsProcessAlive(processId))) {
+				UnsealOwners(entry, i);
+				return false;
+			}
+			if (InterlockedCompareExchange(&owner, Sealed,
+						       processId) == processId)
+				break;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Returns an entry with sealed owners to the free ones.
+ */
+void FreeEntry(RegistryEntry &entry)
+{
+	// Instances waiting on the seal find no process and spawn a new one
+	InterlockedExchange(&entry.processId, 0);
+	InterlockedExchange64(&entry.processStart, 0);
+	InterlockedExchange(&entry.spawner, 0);
+	InterlockedExchange(&entry.state, Free);
+	UnsealOwners(entry, OwnerCount);
+}
+
+/**
+ * @brief Frees the entries of programs that exited while no instance
+ * terminated them, e.g. because their last user crashed.
+ */
+void ReclaimEntries()
+{
+	for (RegistryEntry &entry : table->entries) {
+		if (entry.state != Ready || entry.spawner != 0 ||
+		    IsProcessAlive(entry.processId, entry.processStart) ||
+		    !SealOwners(entry))
+			continue;
+
+		FreeEntry(entry);
+	}
+}
+
+/**
+ * @brief Drops one local use of an entry.
+ * @return The uses left.
+ */
+int DropUse(int index)
+{
+	std::lock_guard<std::mutex> lock(useMutex);
+	if (uses[index] > 0)
+		uses[index]--;
+	return uses[index];
+}
+
+LaunchRegistry::Acquisition AcquireEntry(const std::wstring &path,
+					 int &entryIndex,
+					 unsigned long &processId,
+					 ULONGLONG waitMs)
+{
+	using Acquisition = LaunchRegistry::Acquisition;
+	entryIndex = -1;
+	if (!table || path.size() >= MAX_PATH)
+		return Acquisition::Unavailable;
+
+	uint64_t hash = HashPath(path);
+	int index = -1;
+	for (int attempt = 0; index < 0; attempt++) {
+		if (attempt == 3)
+			return Acquisition::Unavailable;
+		index = FindOrClaimEntry(path, hash);
+		if (index < 0 && attempt == 0) {
+			ReclaimEntries();
+			continue;
+		}
+		if (index < 0)
+			return Acquisition::Unavailable;
+
+		RegistryEntry &entry = table->entries[index];
+		int added = AddOwner(entry, waitMs);
+		if (added < 0)
+			return Acquisition::Unavailable;
+
+		// The entry was freed and reused while this instance waited
+		if (!Matches(entry, path, hash)) {
+			if (added > 0)
+				RemoveOwner(entry);
+			index = -1;
+		}
+	}
+
+	RegistryEntry &entry = table->entries[index];
+	entryIndex = index;
+	{
+		std::lock_guard<std::mutex> lock(useMutex);
+		uses[index]++;
+	}
+
+	ULONGLONG deadline = GetTickCount64() + waitMs;
+	for (;;) {
+		LONG running = entry.processId;
+		if (running != 0 && IsProcessAlive(running, entry.processStart)) {
+			processId = (unsigned long)running;
+			return Acquisition::Adopt;
+		}
+
+		LONG spawner = InterlockedCompareExchange(&entry.spawner,
+							  instanceId, 0);
+		if (spawner == 0 || spawner == instanceId)
+			return Acquisition::Spawn;
+
+		// Take over from an instance that died while spawning
+		if (!IsProcessAlive(spawner)) {
+			InterlockedCompareExchange(&entry.spawner, 0, spawner);
+			continue;
+		}
+
+		if (GetTickCount64() >= deadline) {
+			LaunchRegistry::Release(index);
+			entryIndex = -1;
+			return Acquisition::Unavailable;
+		}
+		Sleep(10);
+	}
+}
+
+} // namespace
+
+bool LaunchRegistry::Open()
+{
+	if (table)
+		return true;
+
+	instanceId = (LONG)GetCurrentProcessId();
+	mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr,
+				     PAGE_READWRITE, 0, sizeof(RegistryTable),
+				     L"Local\\AutostarterLaunchRegistry");
+	if (!mapping) {
+		Host::Log(Host::Warning,
+			  "Failed to create launch registry, error code: %lu",
+			  GetLastError());
+		return false;
+	}
+	bool created = GetLastError() != ERROR_ALREADY_EXISTS;
+
+	table = (RegistryTable *)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0,
+					       0, sizeof(RegistryTable));
+	if (!table) {
+		Close();
+		return false;
+	}
+
+	// New mappings are zero-filled, so only the version needs to be set
+	if (created)
+		InterlockedExchange(&table->version, RegistryVersion);
+	else if (table->version != RegistryVersion) {
+		Host::Log(Host::Warning,
+			  "Launch registry version mismatch, sharing disabled");
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void LaunchRegistry::Close()
+{
+	if (table)
+		UnmapViewOfFile(table);
+	if (mapping)
+		CloseHandle(mapping);
+	table = nullptr;
+	mapping = nullptr;
+}
+
+LaunchRegistry::Acquisition LaunchRegistry::Acquire(const std::wstring &path,
+						    int &entryIndex,
+						    unsigned long &processId)
+{
+	return AcquireEntry(path, entryIndex, processId, SpawnWaitMs);
+}
+
+LaunchRegistry::Acquisition
+LaunchRegistry::TryAcquire(const std::wstring &path, int &entryIndex,
+			   unsigned long &processId)
+{
+	return AcquireEntry(path, entryIndex, processId, 0);
+}
+
+void LaunchRegistry::Retain(int entryIndex)
+{
+	if (!table || entryIndex < 0)
+		return;
+
+	std::lock_guard<std::mutex> lock(useMutex);
+	uses[entryIndex]++;
+}
+
+int LaunchRegistry::Find(unsigned long processId)
+{
+	if (!table || processId == 0)
+		return -1;
+
+	for (int index = 0; index < EntryCount; index++) {
+		const RegistryEntry &entry = table->entries[index];
+		if (entry.state == Ready &&
+		    entry.processId == (LONG)processId)
+			return index;
+	}
+	return -1;
+}
+
+void LaunchRegistry::Publish(int entryIndex, unsigned long processId)
+{
+	if (!table || entryIndex < 0)
+		return;
+
+	RegistryEntry &entry = table->entries[entryIndex];
+	LONG64 start = 0;
+	if (HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION,
+					 FALSE, processId)) {
+		start = GetStartTime(process);
+		CloseHandle(process);
+	}
+
+	// Readers check the start time after the ID, so write it first
+	InterlockedExchange64(&entry.processStart, start);
+	InterlockedExchange(&entry.processId, (LONG)processId);
+	InterlockedExchange(&entry.spawner, 0);
+}
+
+void LaunchRegistry::CancelSpawn(int entryIndex)
+{
+	if (!table || entryIndex < 0)
+		return;
+
+	InterlockedCompareExchange(&table->entries[entryIndex].spawner, 0,
+				   instanceId);
+}
+
+void LaunchRegistry::Release(int entryIndex)
+{
+	if (!table || entryIndex < 0)
+		return;
+
+	if (DropUse(entryIndex) == 0)
+		RemoveOwner(table->entries[entryIndex]);
+}
+
+LaunchRegistry::Termination LaunchRegistry::BeginTerminate(int entryIndex)
+{
+	if (!table || entryIndex < 0)
+		return Termination::Terminate;
+
+	// The owner slot stays until the last local user is gone
+	if (DropUse(entryIndex) > 0)
+		return Termination::UsedHere;
+
+	RegistryEntry &entry = table->entries[entryIndex];
+	RemoveOwner(entry);
+	return SealOwners(entry) ? Termination::Terminate
+				 : Termination::UsedElsewhere;
+}
+
+void LaunchRegistry::EndTerminate(int entryIndex)
+{
+	if (!table || entryIndex < 0)
+		return;
+
+	FreeEntry(table->entries[entryIndex]);
+}
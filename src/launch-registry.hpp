@@ -0,0 +1,121 @@
+#pragma once
+#include <string>
+
+/**
+ * @brief Registry of launched programs shared by all OBS instances of a session.
+ *
+ * Entries live in a named shared-memory table keyed by the program's
+ * resolved path. Every instance that uses a program holds an owner slot in
+ * its entry; slots are claimed and released with atomic compare-exchange
+ * only, so instances never block each other. Within an instance, every
+ * tracked process counts as one use of the entry, and the owner slot is
+ * given up with the last use. Slots of instances that
+ * crashed are pruned whenever the owners are counted, so a program is
+ * terminated only once no running instance uses it anymore. The last
+ * instance seals the entry while it terminates the program and returns it
+ * to the free entries afterwards.
+ */
+class LaunchRegistry {
+public:
+	/**
+	 * @brief Outcome of acquiring a program from the registry.
+	 */
+	enum class Acquisition {
+		Unavailable, ///< Registry not available, launch without sharing
+		Spawn,       ///< Caller must spawn the program and Publish() it
+		Adopt        ///< Program already runs for another instance
+	};
+
+	/**
+	 * @brief Outcome of giving up a program that should quit.
+	 */
+	enum class Termination {
+		Terminate,    ///< Caller terminates the program, then EndTerminate()
+		UsedHere,     ///< Another tracked process of this instance uses it
+		UsedElsewhere ///< Another running instance uses it
+	};
+
+	/**
+	 * @brief Opens or creates the shared table.
+	 * @return true if the registry can be used.
+	 */
+	static bool Open();
+
+	/**
+	 * @brief Unmaps the shared table.
+	 */
+	static void Close();
+
+	/**
+	 * @brief Registers this instance as user of a program. Waits up to 10
+	 * seconds while another instance spawns or terminates it, so call it
+	 * from a worker thread.
+	 * @param path Resolved absolute path of the program.
+	 * @param entry Receives the entry index for later calls.
+	 * @param processId Receives the running process ID on Adopt.
+	 * @return Whether the program must be spawned or can be adopted.
+	 */
+	static Acquisition Acquire(const std::wstring &path, int &entry,
+				   unsigned long &processId);
+
+	/**
+	 * @brief Like Acquire(), but returns Unavailable right away while
+	 * another instance spawns or terminates the program.
+	 */
+	static Acquisition TryAcquire(const std::wstring &path, int &entry,
+				      unsigned long &processId);
+
+	/**
+	 * @brief Adds a use of an entry this instance already holds, for a
+	 * second tracked process of the same program.
+	 * @param entry Entry index from Acquire().
+	 */
+	static void Retain(int entry);
+
+	/**
+	 * @brief Finds the entry of a running program by its process ID.
+	 * Lets the supervisor of a crashed instance check for other users.
+	 * @return The entry index, -1 if the program is not shared.
+	 */
+	static int Find(unsigned long processId);
+
+	/**
+	 * @brief Publishes the process spawned after Acquire() returned Spawn.
+	 * @param entry Entry index from Acquire().
+	 * @param processId ID of the spawned process.
+	 */
+	static void Publish(int entry, unsigned long processId);
+
+	/**
+	 * @brief Gives up the right to spawn after Acquire() returned Spawn.
+	 * @param entry Entry index from Acquire().
+	 */
+	static void CancelSpawn(int entry);
+
+	/**
+	 * @brief Drops one use of a program that keeps running. The last use
+	 * removes this instance as its user.
+	 * @param entry Entry index from Acquire().
+	 */
+	static void Release(int entry);
+
+	/**
+	 * @brief Drops one use of a program that should quit.
+	 *
+	 * With the last use this instance is removed as user. If no other
+	 * running instance uses the program, its entry is sealed: instances
+	 * acquiring it wait until EndTerminate() and then spawn it anew
+	 * instead of adopting the process that is going away.
+	 * @param entry Entry index from Acquire(), -1 for unshared programs.
+	 * @return Whether the caller must terminate the program and then call
+	 * EndTerminate().
+	 */
+	static Termination BeginTerminate(int entry);
+
+	/**
+	 * @brief Frees the entry sealed by BeginTerminate().
+	 * Call after the program was terminated, even if that failed.
+	 * @param entry Entry index from Acquire().
+	 */
+	static void EndTerminate(int entry);
+};
@@ -14,6 +14,8 @@
 #include <QComboBox>
 #include "config.hpp"
 #include "autostart.hpp"
+#include "progress-widget.hpp"
+#include "output-triggers.hpp"
 
 static LaunchWidget *widget = nullptr; ///< Singleton instance of the launch dialog
 
@@ -39,27 +41,53 @@ LaunchWidget::LaunchWidget(QWidget *parent) : QDialog(parent)
     // Setup action buttons
     auto buttonLayout = new QHBoxLayout();
     launchButton = new QPushButton("Launch", this);
+    switchButton = new QPushButton("Switch", this);
+    switchButton->setToolTip(
+        "Quit the programs that are not part of this loadout and launch the missing ones");
     cancelButton = new QPushButton("Skip", this);
 
     buttonLayout->addWidget(launchButton);
+    buttonLayout->addWidget(switchButton);
     buttonLayout->addWidget(cancelButton);
     mainLayout->addLayout(buttonLayout);
 
     // Connect button signals to slots
     connect(launchButton, &QPushButton::clicked, this,
         &LaunchWidget::onLaunchClicked);
+    connect(switchButton, &QPushButton::clicked, this,
+        &LaunchWidget::onSwitchClicked);
     connect(cancelButton, &QPushButton::clicked, this,
         &LaunchWidget::onCancelClicked);
 }
 
 void LaunchWidget::onLaunchClicked()
+{
+    // Launch the applications in the background, next to any that are
+    // already running
+    startJob(AutoStarter::LaunchProgramsAsync(
+        loadoutCombo->currentText().toStdString()));
+}
+
+void LaunchWidget::onSwitchClicked()
+{
+    // Launch only the missing applications, programs of other loadouts
+    // that are still tracked are quit
+    startJob(AutoStarter::SwitchLoadout(
+        loadoutCombo->currentText().toStdString()));
+}
+
+void LaunchWidget::startJob(LaunchJob *job)
 {
     // Save selected loadout as current
     auto &config = PluginConfig::Get();
     config.currentLoadout = loadoutCombo->currentText().toStdString();
+    config.Publish();
     config.Save();
-    // Launch the applications
-    AutoStarter::LaunchPrograms(loadoutCombo->currentText().toStdString());
+    // Follow the progress of the launch
+    if (job) {
+        output_triggers_track_launch(job);
+        LaunchProgressWidget::ShowProgress(job);
+    }
     accept();
 }
 
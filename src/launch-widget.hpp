@@ -6,7 +6,8 @@
  * 
  * Provides a modal dialog that allows users to select which loadout of applications
  * to launch when OBS starts. The dialog includes a dropdown for loadout selection
- * and options to either launch the selected loadout or skip launching entirely.
+ * and options to launch the selected loadout, switch to it from the programs that
+ * are still running, or skip launching entirely.
  */
 
 #include <QtWidgets/QDialog>
@@ -15,11 +16,13 @@
 #include <QComboBox>
 #include <obs-module.h>
 
+class LaunchJob;
+
 /**
  * @brief Dialog widget for loadout selection and launching
  * 
  * Presents a modal dialog with a combobox for loadout selection and
- * Launch/Skip buttons for user interaction.
+ * Launch/Switch/Skip buttons for user interaction.
  */
 class LaunchWidget : public QDialog {
     Q_OBJECT
@@ -39,6 +42,13 @@ private slots:
      */
     void onLaunchClicked();
 
+    /**
+     * @brief Handles the Switch button click
+     * Saves the selected loadout, quits the programs of other loadouts
+     * and launches the missing ones
+     */
+    void onSwitchClicked();
+
     /**
      * @brief Handles the Skip button click
      * Closes the dialog without launching anything
@@ -46,8 +56,15 @@ private slots:
     void onCancelClicked();
 
 private:
+    /**
+     * @brief Saves the selected loadout as current and follows the
+     * progress of its launch
+     */
+    void startJob(LaunchJob *job);
+
     QLabel *loadoutTitle;
     QPushButton *launchButton;
+    QPushButton *switchButton;
     QPushButton *cancelButton;
 };
 
@@ -0,0 +1,67 @@
+/**
+ * @file obs-host.cpp
+ * @brief Implementation of the OBS host callbacks
+ */
+
+#include "obs-host.hpp"
+#include "host.hpp"
+#include "procedures.hpp"
+#include <obs-module.h>
+
+static void Log(Host::Level level, const char *message)
+{
+	blog((int)level, "%s", message);
+}
+
+static std::string ConfigPath(const char *file)
+{
+	char *path = obs_module_config_path(file);
+	if (!path)
+		return std::string();
+
+	std::string result = path;
+	bfree(path);
+	return result;
+}
+
+static FrameStats SampleFrames()
+{
+	FrameStats stats;
+	stats.laggedFrames = obs_get_lagged_frames();
+	if (video_t *video = obs_get_video())
+		stats.skippedFrames = video_output_get_skipped_frames(video);
+
+	obs_enum_outputs(
+		[](void *param, obs_output_t *output) {
+			if (obs_output_active(output))
+				static_cast<FrameStats *>(param)->droppedFrames +=
+					obs_output_get_frames_dropped(output);
+			return true;
+		},
+		&stats);
+	return stats;
+}
+
+void obs_host_init()
+{
+	Host::Callbacks callbacks;
+	callbacks.log = Log;
+	callbacks.configPath = ConfigPath;
+	callbacks.frameStats = SampleFrames;
+	callbacks.programLaunched = procedures_signal_launched;
+	callbacks.programFailed = procedures_signal_failed;
+	callbacks.programExited = procedures_signal_exited;
+	Host::Install(callbacks);
+}
+
+std::string obs_host_module_directory()
+{
+	const char *path = obs_get_module_binary_path(obs_current_module());
+	if (!path)
+		return std::string();
+
+	std::string directory = path;
+	size_t separator = directory.find_last_of("\\/");
+	return separator == std::string::npos ? std::string()
+					      : directory.substr(0, separator);
+}
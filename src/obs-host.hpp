@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+
+/**
+ * @file obs-host.hpp
+ * @brief Hosts the launcher core inside OBS
+ *
+ * Routes the core's logging to the OBS log, keeps its files in the plugin
+ * config directory, samples frame counters from libobs and forwards
+ * program events to the libobs signals of procedures.hpp.
+ */
+
+/**
+ * @brief Installs the OBS callbacks, call before any other core API
+ */
+void obs_host_init();
+
+/**
+ * @brief Returns the directory the plugin binary was loaded from
+ */
+std::string obs_host_module_directory();
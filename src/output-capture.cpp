@@ -0,0 +1,281 @@
+// Moves captured program output into rotating log files
+#include <windows.h>
+#include "output-capture.hpp"
+#include "constants.hpp"
+#include "host.hpp"
+#include <QDir>
+#include <QFileInfo>
+#include <QString>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <cwctype>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr DWORD BufferSize = 64 * 1024;
+
+/**
+ * @brief Server end of one program's output pipe and its log file.
+ */
+struct CapturedPipe {
+	HANDLE pipe = INVALID_HANDLE_VALUE;
+	HANDLE logFile = INVALID_HANDLE_VALUE;
+	std::wstring logPath;
+	unsigned long long logSize = 0;
+	OVERLAPPED overlapped = {};
+	bool readPending = false;
+	char buffer[BufferSize];
+
+	~CapturedPipe()
+	{
+		if (readPending) {
+			// The buffer must outlive the cancelled read
+			DWORD bytesRead = 0;
+			CancelIo(pipe);
+			GetOverlappedResult(pipe, &overlapped, &bytesRead, TRUE);
+		}
+		if (pipe != INVALID_HANDLE_VALUE)
+			CloseHandle(pipe);
+		if (overlapped.hEvent)
+			CloseHandle(overlapped.hEvent);
+		if (logFile != INVALID_HANDLE_VALUE)
+			CloseHandle(logFile);
+	}
+};
+
+std::thread captureThread;
+std::atomic<bool> stopRequested{false};
+HANDLE wakeEvent = nullptr;
+std::mutex pendingMutex;
+std::vector<std::unique_ptr<CapturedPipe>> pendingPipes;
+std::atomic<unsigned int> pipeCounter{0};
+
+std::wstring LogFileName(const std::wstring &path, int generation)
+{
+	return generation == 0 ? path
+			       : path + L"." + std::to_wstring(generation);
+}
+
+/**
+ * @brief Shifts log.N to log.N+1, dropping the oldest, and opens a fresh log.
+ */
+bool RotateLog(CapturedPipe &captured)
+{
+	if (captured.logFile != INVALID_HANDLE_VALUE)
+		CloseHandle(captured.logFile);
+
+	DeleteFileW(LogFileName(captured.logPath,
+				Constants::OUTPUT_LOG_MAX_FILES)
+			    .c_str());
+	for (int i = Constants::OUTPUT_LOG_MAX_FILES - 1; i >= 0; i--) {
+		MoveFileExW(LogFileName(captured.logPath, i).c_str(),
+			    LogFileName(captured.logPath, i + 1).c_str(),
+			    MOVEFILE_REPLACE_EXISTING);
+	}
+
+	captured.logFile = CreateFileW(
+		captured.logPath.c_str(), GENERIC_WRITE,
+		FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, CREATE_ALWAYS,
+		FILE_ATTRIBUTE_NORMAL, nullptr);
+	captured.logSize = 0;
+	return captured.logFile != INVALID_HANDLE_VALUE;
+}
+
+/**
+ * @brief Starts an overlapped read. Returns false once the pipe is closed.
+ */
+bool IssueRead(CapturedPipe &captured)
+{
+	if (captured.readPending)
+		return true;
+
+	if (!ReadFile(captured.pipe, captured.buffer, BufferSize, nullptr,
+		      &captured.overlapped) &&
+	    GetLastError() != ERROR_IO_PENDING)
+		return false;
+
+	// Completed reads signal the event as well, so both cases are
+	// handled by the wait loop
+	captured.readPending = true;
+	return true;
+}
+
+/**
+ * @brief Writes a completed read to the log. Returns false once the pipe is closed.
+ */
+bool CompleteRead(CapturedPipe &captured)
+{
+	captured.readPending = false;
+
+	DWORD bytesRead = 0;
+	if (!GetOverlappedResult(captured.pipe, &captured.overlapped,
+				 &bytesRead, FALSE))
+		return false;
+
+	if (captured.logFile != INVALID_HANDLE_VALUE && bytesRead > 0) {
+		DWORD written = 0;
+		WriteFile(captured.logFile, captured.buffer, bytesRead,
+			  &written, nullptr);
+		captured.logSize += written;
+		if (captured.logSize > Constants::OUTPUT_LOG_MAX_BYTES)
+			RotateLog(captured);
+	}
+	return true;
+}
+
+void CaptureLoop()
+{
+	std::vector<std::unique_ptr<CapturedPipe>> pipes;
+	std::vector<HANDLE> waitHandles;
+
+	while (!stopRequested) {
+		{
+			std::lock_guard<std::mutex> lock(pendingMutex);
+			for (auto &pending : pendingPipes)
+				pipes.push_back(std::move(pending));
+			pendingPipes.clear();
+		}
+
+		// Start reads and drop pipes whose program has exited
+		for (auto it = pipes.begin(); it != pipes.end();) {
+			it = IssueRead(**it) ? std::next(it) : pipes.erase(it);
+		}
+
+		// Pipes past the wait limit are picked up as earlier ones close
+		waitHandles.clear();
+		waitHandles.push_back(wakeEvent);
+		for (auto &captured : pipes) {
+			if (waitHandles.size() == MAXIMUM_WAIT_OBJECTS)
+				break;
+			waitHandles.push_back(captured->overlapped.hEvent);
+		}
+
+		DWORD result = WaitForMultipleObjects((DWORD)waitHandles.size(),
+						      waitHandles.data(), FALSE,
+						      INFINITE);
+		if (result == WAIT_FAILED)
+			break;
+
+		size_t index = result - WAIT_OBJECT_0;
+		if (index == 0 || index >= waitHandles.size())
+			continue;
+
+		auto &captured = pipes[index - 1];
+		if (!CompleteRead(*captured))
+			pipes.erase(pipes.begin() + (index - 1));
+	}
+}
+
+} // namespace
+
+bool OutputCapture::CreatePipe(const std::string &loadoutName,
+			       const std::wstring &programPath,
+			       const std::string &programName,
+			       HANDLE &childHandle)
+{
+	childHandle = nullptr;
+
+	// The loop thread is started lazily with the first captured program
+	{
+		std::lock_guard<std::mutex> lock(pendingMutex);
+		if (!captureThread.joinable()) {
+			wakeEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+			stopRequested = false;
+			captureThread = std::thread(CaptureLoop);
+		}
+	}
+
+	std::wstring pipeName =
+		L"\\\\.\\pipe\\autostarter-" +
+		std::to_wstring(GetCurrentProcessId()) + L"-" +
+		std::to_wstring(pipeCounter.fetch_add(1));
+
+	auto captured = std::make_unique<CapturedPipe>();
+	captured->pipe = CreateNamedPipeW(
+		pipeName.c_str(),
+		PIPE_ACCESS_INBOUND | FILE_FLAG_OVERLAPPED |
+			FILE_FLAG_FIRST_PIPE_INSTANCE,
+		PIPE_TYPE_BYTE | PIPE_WAIT, 1, 0, BufferSize, 0, nullptr);
+	if (captured->pipe == INVALID_HANDLE_VALUE) {
+		Host::Log(Host::Warning,
+			  "Failed to create output pipe for '%s', error code: %lu",
+			  programName.c_str(), GetLastError());
+		return false;
+	}
+	captured->overlapped.hEvent =
+		CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+	// Only the child's end is inheritable
+	SECURITY_ATTRIBUTES inheritable = {sizeof(inheritable), nullptr, TRUE};
+	childHandle = CreateFileW(pipeName.c_str(), GENERIC_WRITE, 0,
+				  &inheritable, OPEN_EXISTING, 0, nullptr);
+	if (childHandle == INVALID_HANDLE_VALUE) {
+		childHandle = nullptr;
+		Host::Log(Host::Warning,
+			  "Failed to open output pipe for '%s', error code: %lu",
+			  programName.c_str(), GetLastError());
+		return false;
+	}
+
+	QString logPath =
+		QString::fromStdString(LogPath(loadoutName, programPath));
+	QDir().mkpath(QFileInfo(logPath).absolutePath());
+	captured->logPath = QDir::toNativeSeparators(logPath).toStdWString();
+	RotateLog(*captured);
+
+	{
+		std::lock_guard<std::mutex> lock(pendingMutex);
+		pendingPipes.push_back(std::move(captured));
+	}
+	SetEvent(wakeEvent);
+	return true;
+}
+
+void OutputCapture::Stop()
+{
+	if (!captureThread.joinable())
+		return;
+
+	stopRequested = true;
+	SetEvent(wakeEvent);
+	captureThread.join();
+
+	std::lock_guard<std::mutex> lock(pendingMutex);
+	pendingPipes.clear();
+	CloseHandle(wakeEvent);
+	wakeEvent = nullptr;
+}
+
+std::string OutputCapture::LogPath(const std::string &loadoutName,
+				   const std::wstring &programPath)
+{
+	// FNV-1a over the lowercase path, paths are case-insensitive
+	uint32_t hash = 2166136261u;
+	for (wchar_t c : programPath) {
+		hash ^= (uint32_t)towlower(c);
+		hash *= 16777619u;
+	}
+
+	// Loadout names may contain characters that are invalid in file names
+	std::string directory = loadoutName;
+	for (char &c : directory) {
+		if ((unsigned char)c < 0x20 || strchr("<>:\"/\\|?*", c))
+			c = '_';
+	}
+
+	std::wstring baseName =
+		programPath.substr(programPath.find_last_of(L"\\/") + 1);
+	baseName = baseName.substr(0, baseName.find_last_of(L'.'));
+
+	char suffix[16];
+	snprintf(suffix, sizeof(suffix), "-%08x.log", hash);
+	std::string fileName =
+		"logs/" + directory + "/" +
+		QString::fromStdWString(baseName).toStdString() + suffix;
+	return Host::ConfigPath(fileName.c_str());
+}
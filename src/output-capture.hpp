@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+
+// Forward declare Windows types
+using HANDLE = void *;
+
+/**
+ * @brief Captures the output of launched programs into rotating log files.
+ *
+ * Each captured program writes its stdout and stderr into one pipe. A
+ * single background thread waits on all pipes with overlapped I/O and
+ * appends whatever arrives to the program's log file, rotating it once it
+ * exceeds Constants::OUTPUT_LOG_MAX_BYTES.
+ */
+class OutputCapture {
+public:
+	/**
+	 * @brief Creates a capture pipe for a program that is about to launch.
+	 * @param loadoutName Loadout the program is launched from.
+	 * @param programPath Resolved path of the program, names the log file.
+	 * @param programName Name used for logging.
+	 * @param childHandle Receives the inheritable write end to pass to the child.
+	 *        The caller must close it once the child has been created.
+	 * @return true if the pipe was created and registered.
+	 */
+	static bool CreatePipe(const std::string &loadoutName,
+			       const std::wstring &programPath,
+			       const std::string &programName,
+			       HANDLE &childHandle);
+
+	/**
+	 * @brief Stops the capture thread and closes all pipes and log files.
+	 */
+	static void Stop();
+
+	/**
+	 * @brief Returns the path of the current log file of a program.
+	 *
+	 * Logs are kept per loadout, and the file name carries a hash of the
+	 * program path, so programs sharing an executable name never write
+	 * into the same file.
+	 * @param loadoutName Loadout the program is launched from.
+	 * @param programPath Resolved path of the program.
+	 */
+	static std::string LogPath(const std::string &loadoutName,
+				   const std::wstring &programPath);
+};
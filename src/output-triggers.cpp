@@ -0,0 +1,155 @@
+/**
+ * @file output-triggers.cpp
+ * @brief Implementation of output-triggered loadouts
+ */
+
+#include "output-triggers.hpp"
+#include <obs-module.h>
+#include <obs-frontend-api.h>
+#include <QPointer>
+#include <map>
+#include "config.hpp"
+#include "autostart.hpp"
+#include "launch-job.hpp"
+#include "settings-widget.hpp"
+
+/// Jobs still launching, keyed by loadout name
+static std::map<std::string, QPointer<LaunchJob>> pendingJobs;
+
+static bool AnyOutputActive()
+{
+	return obs_frontend_streaming_active() ||
+	       obs_frontend_recording_active() ||
+	       obs_frontend_replay_buffer_active();
+}
+
+/**
+ * @brief Freezes or thaws every loadout that opted into freezing when idle
+ */
+static void SetIdleLoadoutsFrozen(bool frozen)
+{
+	bool changed = false;
+	auto config = PluginConfig::Get().Snapshot();
+	for (const auto &loadout : config->loadouts) {
+		if (!loadout.freezeWhenIdle ||
+		    AutoStarter::IsLoadoutFrozen(loadout.name) == frozen ||
+		    !AutoStarter::IsLoadoutLaunched(loadout.name))
+			continue;
+
+		AutoStarter::SetLoadoutFrozen(loadout.name, frozen);
+		changed = true;
+	}
+
+	if (changed)
+		SettingsWidget::RefreshLoadoutState();
+}
+
+static void LaunchTriggered(LaunchTrigger trigger)
+{
+	// Resume frozen helpers first, they are ready immediately
+	SetIdleLoadoutsFrozen(false);
+
+	auto config = PluginConfig::Get().Snapshot();
+	if (!config->enabled)
+		return;
+
+	for (const auto &loadout : config->loadouts) {
+		if (loadout.trigger != trigger)
+			continue;
+		// Loadouts kept frozen between outputs were just resumed, and a
+		// launch still in progress covers the rest
+		auto pending = pendingJobs.find(loadout.name);
+		if (AutoStarter::IsLoadoutLaunched(loadout.name) ||
+		    (pending != pendingJobs.end() && pending->second)) {
+			blog(LOG_INFO, "Loadout '%s' is already running for %s",
+			     loadout.name.c_str(), TriggerToString(trigger));
+			continue;
+		}
+
+		blog(LOG_INFO, "Launching loadout '%s' for %s",
+		     loadout.name.c_str(), TriggerToString(trigger));
+		if (LaunchJob *job =
+			    AutoStarter::LaunchProgramsAsync(loadout.name)) {
+			pendingJobs[loadout.name] = job;
+			job->start();
+		}
+	}
+}
+
+static void QuitTriggered(LaunchTrigger trigger)
+{
+	auto config = PluginConfig::Get().Snapshot();
+	for (const auto &loadout : config->loadouts) {
+		// Loadouts that freeze when idle are kept for the next output
+		if (loadout.trigger != trigger || loadout.freezeWhenIdle)
+			continue;
+
+		blog(LOG_INFO, "Quitting loadout '%s' after %s stopped",
+		     loadout.name.c_str(), TriggerToString(trigger));
+		AutoStarter::QuitLoadout(loadout.name);
+
+		// Programs of a launch that is still running are quit once
+		// the launch finishes
+		auto it = pendingJobs.find(loadout.name);
+		if (it != pendingJobs.end()) {
+			if (it->second) {
+				std::string name = loadout.name;
+				QObject::connect(it->second,
+						 &LaunchJob::finished, [name]() {
+							 AutoStarter::QuitLoadout(
+								 name);
+						 });
+			}
+			pendingJobs.erase(it);
+		}
+	}
+
+	if (!AnyOutputActive())
+		SetIdleLoadoutsFrozen(true);
+}
+
+static void OnFrontendEvent(enum obs_frontend_event event, void *)
+{
+	switch (event) {
+	case OBS_FRONTEND_EVENT_STREAMING_STARTING:
+		LaunchTriggered(LaunchTrigger::Streaming);
+		break;
+	case OBS_FRONTEND_EVENT_STREAMING_STOPPED:
+		QuitTriggered(LaunchTrigger::Streaming);
+		break;
+	case OBS_FRONTEND_EVENT_RECORDING_STARTING:
+		LaunchTriggered(LaunchTrigger::Recording);
+		break;
+	case OBS_FRONTEND_EVENT_RECORDING_STOPPED:
+		QuitTriggered(LaunchTrigger::Recording);
+		break;
+	case OBS_FRONTEND_EVENT_REPLAY_BUFFER_STARTING:
+		LaunchTriggered(LaunchTrigger::ReplayBuffer);
+		break;
+	case OBS_FRONTEND_EVENT_REPLAY_BUFFER_STOPPED:
+		QuitTriggered(LaunchTrigger::ReplayBuffer);
+		break;
+	default:
+		break;
+	}
+}
+
+void output_triggers_init()
+{
+	obs_frontend_add_event_callback(OnFrontendEvent, nullptr);
+}
+
+void output_triggers_free()
+{
+	obs_frontend_remove_event_callback(OnFrontendEvent, nullptr);
+	pendingJobs.clear();
+}
+
+void output_triggers_track_launch(LaunchJob *job)
+{
+	// Loadouts launched while idle have nothing to run for yet
+	QObject::connect(job, &LaunchJob::finished, []() {
+		if (!AnyOutputActive())
+			SetIdleLoadoutsFrozen(true);
+	});
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+/**
+ * @file output-triggers.hpp
+ * @brief Launches and quits loadouts alongside OBS outputs
+ *
+ * Loadouts bound to streaming, recording or the replay buffer are launched
+ * as soon as OBS reports that the output is starting, so the programs come
+ * up while the output connects, and are quit again once it has stopped.
+ * Loadouts that freeze when idle are suspended instead while no output is
+ * active and resumed as soon as one starts.
+ */
+
+class LaunchJob;
+
+/**
+ * @brief Registers the frontend event callback that drives output triggers
+ */
+void output_triggers_init();
+
+/**
+ * @brief Removes the frontend event callback
+ */
+void output_triggers_free();
+
+/**
+ * @brief Freezes the idle loadouts once a launch outside of an output
+ * finishes while no output is active
+ *
+ * Output events only freeze loadouts when an output stops, so loadouts
+ * launched from the startup path or the dialogs would otherwise run unfrozen
+ * until the first output came and went. Call it for every such job before
+ * starting it.
+ */
+void output_triggers_track_launch(LaunchJob *job);
@@ -0,0 +1,278 @@
+// Resolves bare command names through a watched index of the PATH
+#include <windows.h>
+#include "path-index.hpp"
+#include "host.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cwctype>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief Executables of one PATH directory, keyed by lowercase file name.
+ */
+struct IndexedDirectory {
+	std::wstring path;
+	std::unordered_map<std::wstring, std::wstring> files;
+	std::atomic<bool> stale{true};
+};
+
+std::mutex indexMutex;
+bool indexBuilt = false;
+std::vector<std::unique_ptr<IndexedDirectory>> directories;
+std::vector<std::wstring> extensions; ///< Lowercase PATHEXT entries, e.g. ".exe"
+std::unordered_map<std::wstring, std::wstring> commands; ///< Merged lookup table
+
+std::thread watchThread;
+HANDLE stopEvent = nullptr;
+
+std::wstring ToLower(std::wstring value)
+{
+	std::transform(value.begin(), value.end(), value.begin(),
+		       [](wchar_t c) { return (wchar_t)towlower(c); });
+	return value;
+}
+
+std::wstring ReadVariable(const wchar_t *name)
+{
+	DWORD size = GetEnvironmentVariableW(name, nullptr, 0);
+	if (size == 0)
+		return std::wstring();
+
+	std::wstring value(size, L'\0');
+	size = GetEnvironmentVariableW(name, value.data(), size);
+	value.resize(size);
+	return value;
+}
+
+std::vector<std::wstring> Split(const std::wstring &value)
+{
+	std::vector<std::wstring> parts;
+	size_t start = 0;
+	while (start <= value.size()) {
+		size_t end = value.find(L';', start);
+		if (end == std::wstring::npos)
+			end = value.size();
+		std::wstring part = value.substr(start, end - start);
+		// PATH entries may be quoted
+		part.erase(std::remove(part.begin(), part.end(), L'"'),
+			   part.end());
+		while (!part.empty() &&
+		       (part.back() == L'\\' || part.back() == L'/'))
+			part.pop_back();
+		if (!part.empty())
+			parts.push_back(part);
+		start = end + 1;
+	}
+	return parts;
+}
+
+bool IsExecutable(const std::wstring &lowerName)
+{
+	size_t dot = lowerName.rfind(L'.');
+	if (dot == std::wstring::npos)
+		return false;
+	return std::find(extensions.begin(), extensions.end(),
+			 lowerName.substr(dot)) != extensions.end();
+}
+
+/**
+ * @brief Lists the executables of a single directory.
+ */
+void ScanDirectory(IndexedDirectory &directory)
+{
+	directory.stale = false;
+	directory.files.clear();
+
+	WIN32_FIND_DATAW data;
+	HANDLE find = FindFirstFileExW((directory.path + L"\\*").c_str(),
+				       FindExInfoBasic, &data,
+				       FindExSearchNameMatch, nullptr,
+				       FIND_FIRST_EX_LARGE_FETCH);
+	if (find == INVALID_HANDLE_VALUE)
+		return;
+
+	do {
+		if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			continue;
+
+		std::wstring lowerName = ToLower(data.cFileName);
+		if (IsExecutable(lowerName))
+			directory.files.emplace(lowerName,
+						directory.path + L"\\" +
+							data.cFileName);
+	} while (FindNextFileW(find, &data));
+	FindClose(find);
+}
+
+/**
+ * @brief Rebuilds the merged table, earlier PATH directories take precedence.
+ */
+void MergeIndex()
+{
+	commands.clear();
+	for (const auto &directory : directories) {
+		for (const auto &[lowerName, fullPath] : directory->files)
+			commands.emplace(lowerName, fullPath);
+
+		// Names without extension try the extensions in PATHEXT order
+		for (const auto &extension : extensions) {
+			for (const auto &[lowerName, fullPath] :
+			     directory->files) {
+				size_t stem = lowerName.size() - extension.size();
+				if (lowerName.size() > extension.size() &&
+				    lowerName.compare(stem, std::wstring::npos,
+						      extension) == 0)
+					commands.emplace(lowerName.substr(0, stem),
+							 fullPath);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Marks directories stale whenever files in them are added, removed or renamed.
+ */
+void WatchLoop(std::vector<HANDLE> notifications,
+	       std::vector<IndexedDirectory *> watched)
+{
+	std::vector<HANDLE> waitHandles = notifications;
+	waitHandles.insert(waitHandles.begin(), stopEvent);
+
+	while (true) {
+		DWORD result = WaitForMultipleObjects((DWORD)waitHandles.size(),
+						      waitHandles.data(), FALSE,
+						      INFINITE);
+		if (result == WAIT_OBJECT_0 || result == WAIT_FAILED)
+			break;
+
+		size_t i = result - WAIT_OBJECT_0 - 1;
+		if (i >= notifications.size())
+			break;
+
+		watched[i]->stale = true;
+		FindNextChangeNotification(notifications[i]);
+	}
+
+	for (HANDLE notification : notifications)
+		FindCloseChangeNotification(notification);
+}
+
+/**
+ * @brief Lists all PATH directories and starts watching them. Called with indexMutex held.
+ */
+void BuildIndex()
+{
+	indexBuilt = true;
+
+	extensions.clear();
+	std::wstring pathExt = ReadVariable(L"PATHEXT");
+	for (const auto &extension :
+	     Split(pathExt.empty() ? L".COM;.EXE;.BAT;.CMD" : pathExt))
+		extensions.push_back(ToLower(extension));
+
+	std::vector<HANDLE> notifications;
+	std::vector<IndexedDirectory *> watched;
+	for (const auto &path : Split(ReadVariable(L"PATH"))) {
+		auto directory = std::make_unique<IndexedDirectory>();
+		directory->path = path;
+		ScanDirectory(*directory);
+
+		// One wait slot is taken by the stop event
+		if (notifications.size() < MAXIMUM_WAIT_OBJECTS - 1) {
+			HANDLE notification = FindFirstChangeNotificationW(
+				path.c_str(), FALSE,
+				FILE_NOTIFY_CHANGE_FILE_NAME);
+			if (notification != INVALID_HANDLE_VALUE) {
+				notifications.push_back(notification);
+				watched.push_back(directory.get());
+			}
+		} else {
+			// Unwatched directories are listed again on every lookup
+			directory->stale = true;
+		}
+		directories.push_back(std::move(directory));
+	}
+	MergeIndex();
+
+	Host::Log(Host::Debug, "Indexed %zu commands in %zu PATH directories",
+		  commands.size(), directories.size());
+
+	stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+	if (!stopEvent) {
+		for (HANDLE notification : notifications)
+			FindCloseChangeNotification(notification);
+		return;
+	}
+	watchThread = std::thread(WatchLoop, std::move(notifications),
+				  std::move(watched));
+}
+
+/**
+ * @brief Builds the index on first use and lists the directories that
+ * changed since. Requires indexMutex.
+ */
+void Refresh()
+{
+	if (!indexBuilt) {
+		BuildIndex();
+		return;
+	}
+
+	bool changed = false;
+	for (auto &directory : directories) {
+		if (directory->stale) {
+			ScanDirectory(*directory);
+			changed = true;
+		}
+	}
+	if (changed)
+		MergeIndex();
+}
+
+} // namespace
+
+bool PathIndex::Resolve(const std::wstring &name, std::wstring &fullPath)
+{
+	std::lock_guard<std::mutex> lock(indexMutex);
+	Refresh();
+
+	auto it = commands.find(ToLower(name));
+	if (it == commands.end())
+		return false;
+
+	fullPath = it->second;
+	return true;
+}
+
+bool PathIndex::IsCurrent(const std::wstring &lowercaseName,
+			  const std::wstring &fullPath)
+{
+	std::lock_guard<std::mutex> lock(indexMutex);
+	Refresh();
+
+	auto it = commands.find(lowercaseName);
+	return it == commands.end() ||
+	       _wcsicmp(it->second.c_str(), fullPath.c_str()) == 0;
+}
+
+void PathIndex::Stop()
+{
+	std::lock_guard<std::mutex> lock(indexMutex);
+	if (watchThread.joinable()) {
+		SetEvent(stopEvent);
+		watchThread.join();
+	}
+	if (stopEvent) {
+		CloseHandle(stopEvent);
+		stopEvent = nullptr;
+	}
+	directories.clear();
+	commands.clear();
+	indexBuilt = false;
+}
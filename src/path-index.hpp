@@ -0,0 +1,36 @@
+#pragma once
+#include <string>
+
+/**
+ * @brief Index of the executables found in the directories on the PATH.
+ *
+ * The index is built on first use by listing every PATH directory once and
+ * keeping the files whose extension is listed in PATHEXT. A background
+ * thread watches the directories for added, removed or renamed files and
+ * marks them stale, so only the changed directories are listed again.
+ */
+class PathIndex {
+public:
+	/**
+	 * @brief Resolves a bare command name the way the command prompt does.
+	 * @param name Command name with or without extension, e.g. "notepad".
+	 * @param fullPath Receives the absolute path of the first match on the PATH.
+	 * @return true if the command was found.
+	 */
+	static bool Resolve(const std::wstring &name, std::wstring &fullPath);
+
+	/**
+	 * @brief Checks without allocating whether a command still resolves to
+	 * the path it was resolved to before.
+	 * @param lowercaseName Command name in lowercase, as used by the index.
+	 * @param fullPath Path the command resolved to before.
+	 * @return true if the command resolves to fullPath, or cannot be found.
+	 */
+	static bool IsCurrent(const std::wstring &lowercaseName,
+			      const std::wstring &fullPath);
+
+	/**
+	 * @brief Stops watching the PATH directories and drops the index.
+	 */
+	static void Stop();
+};
@@ -7,6 +7,7 @@
  * - Configurable auto-launch behavior
  * - Multiple loadout support
  * - Optional process termination on OBS shutdown
+ * - Loadouts that run only while streaming, recording or replay buffering
  * 
  * Plugin Name
  * Copyright (C) <2024> <DaviBe> <davi.be92@gmail.com>
@@ -31,18 +32,115 @@
 #include "settings-widget.hpp"
 #include "config.hpp"
 #include "autostart.hpp"
+#include "output-triggers.hpp"
+#include "resource-sampler.hpp"
+#include "trace.hpp"
+#include "constants.hpp"
+#include "launch-job.hpp"
+#include "launch-registry.hpp"
+#include "launch-journal.hpp"
+#include "output-capture.hpp"
+#include "preflight.hpp"
+#include "path-index.hpp"
+#include "file-handlers.hpp"
+#include "process-events.hpp"
+#include "supervisor.hpp"
+#include "procedures.hpp"
+#include "obs-host.hpp"
+#include "status-page.hpp"
+#include "launch-history.hpp"
+#include <util/platform.h>
 #include <QMessageBox>
+#include <array>
 
 OBS_DECLARE_MODULE()
 
+/**
+ * @brief Measures how long each phase of obs_module_load takes
+ *
+ * Every call to Mark() closes the phase that started at the previous mark.
+ * Report() logs the breakdown and warns when the plugin exceeds its share
+ * of the OBS startup budget.
+ */
+class StartupProfiler {
+public:
+	StartupProfiler() : start(os_gettime_ns()), last(start) {}
+
+	void Mark(const char *phase)
+	{
+		uint64_t now = os_gettime_ns();
+		if (count < phases.size())
+			phases[count++] = {phase, now - last};
+		Trace::AddSpan(phase, "startup", last, now);
+		last = now;
+	}
+
+	void Report() const
+	{
+		double totalMs = (double)(last - start) / 1000000.0;
+		for (size_t i = 0; i < count; i++) {
+			blog(LOG_DEBUG, "Startup phase '%s': %.3f ms",
+			     phases[i].name,
+			     (double)phases[i].durationNs / 1000000.0);
+		}
+
+		if (totalMs > Constants::STARTUP_BUDGET_MS) {
+			blog(LOG_WARNING,
+			     "Plugin load took %.3f ms, over the budget of %.1f ms",
+			     totalMs, Constants::STARTUP_BUDGET_MS);
+			for (size_t i = 0; i < count; i++) {
+				blog(LOG_WARNING, "  %s: %.3f ms",
+				     phases[i].name,
+				     (double)phases[i].durationNs / 1000000.0);
+			}
+		} else {
+			blog(LOG_INFO, "Plugin load took %.3f ms", totalMs);
+		}
+	}
+
+private:
+	struct Phase {
+		const char *name;
+		uint64_t durationNs;
+	};
+
+	std::array<Phase, 8> phases = {};
+	size_t count = 0;
+	uint64_t start;
+	uint64_t last;
+};
+
+/**
+ * @brief Launches a loadout in the background so OBS startup is not delayed
+ */
+static void LaunchInBackground(const std::string &loadoutName)
+{
+	// A dry run logs the predicted timeline of startup launches
+	if (AutoStarter::IsDryRun()) {
+		auto config = PluginConfig::Get().Snapshot();
+		if (auto plan = config->GetPlan(loadoutName))
+			blog(LOG_INFO, "%s",
+			     LaunchHistory::Report(*plan,
+						   config->maxParallelLaunches)
+				     .c_str());
+		return;
+	}
+
+	if (LaunchJob *job = AutoStarter::LaunchProgramsAsync(loadoutName)) {
+		output_triggers_track_launch(job);
+		job->start();
+	}
+}
+
 /**
  * @brief Initializes the Autostarter plugin and handles loadout launching
  * 
  * This function:
- * 1. Checks for command line arguments (--autostarter <loadout>)
- * 2. Sets up the Tools menu integration
- * 3. Loads plugin configuration
- * 4. Launches applications based on:
+ * 1. Hooks the launcher core up to OBS and starts the supervisor helper
+ * 2. Checks for command line arguments (--autostarter <loadout>)
+ * 3. Sets up the Tools menu integration
+ * 4. Loads plugin configuration and registers output triggers
+ * 5. Launches applications based on:
  *    - Command line loadout (highest priority)
  *    - Auto-launch settings (if enabled)
  *    - User prompt (if askToLaunch is enabled)
@@ -51,25 +149,76 @@ OBS_DECLARE_MODULE()
  */
 bool obs_module_load(void)
 {
+	StartupProfiler profiler;
+
+	// Route core logging, paths and events through OBS
+	obs_host_init();
+
+	// Start the helper that spawns programs while OBS is still small
+	Supervisor::Start(obs_host_module_directory());
+	profiler.Mark("supervisor");
 
 	struct obs_cmdline_args cmdargs = obs_get_cmdline_args();
 
 	// Look for our custom argument | --autostarter <"loadout"> / This overrides the enabled and askToLaunch check
+	// --autostarter-trace records a launch timeline that is written on exit
+	// --autostarter-dry-run only logs launches, and the predicted timeline of
+	// startup launches
 	std::string cmdLoadout;
 	for (int i = 1; i < cmdargs.argc; i++) {
 		std::string arg = cmdargs.argv[i];
 		if (arg == "--autostarter" && i + 1 < cmdargs.argc) {
-			cmdLoadout = cmdargs.argv[i + 1];
-			break;
+			cmdLoadout = cmdargs.argv[++i];
+		} else if (arg == "--autostarter-trace") {
+			Trace::Enable();
+		} else if (arg == "--autostarter-dry-run") {
+			AutoStarter::SetDryRun(true);
 		}
 	}
 
+	TraceSpan loadSpan("obs_module_load", "module");
+	profiler.Mark("command line");
+
 	// Add menu item to existing Tools menu
 	obs_frontend_add_tools_menu_item(
 		"Autostarter", [](void *) { SettingsWidget::ShowSettings(); },
 		nullptr);
+	profiler.Mark("menu registration");
 
 	PluginConfig::Get().Load();
+	profiler.Mark("config load");
+
+	// Created on the UI thread, launches report to it from any thread.
+	// Programs that exited are dropped once their status arrives there.
+	QObject::connect(&ProcessEvents::Get(), &ProcessEvents::statusChanged,
+			 [](const std::vector<ProcessStatus> &changes) {
+				 for (const auto &status : changes) {
+					 if (!status.running) {
+						 AutoStarter::PruneExited();
+						 break;
+					 }
+				 }
+			 });
+
+	// Flag missing or broken programs in the background
+	Preflight::Get().Start();
+
+	// Share launched programs with other OBS instances
+	LaunchRegistry::Open();
+
+	// Publish the tracked programs for external monitors
+	StatusPage::Open();
+
+	// Pick up programs that survived a crash of the previous session
+	AutoStarter::RecoverProcesses(PluginConfig::Get().quitRecoveredPrograms);
+
+	// Launch and quit output-bound loadouts alongside OBS outputs
+	output_triggers_init();
+	ResourceSampler::Start();
+
+	// Let other plugins drive loadouts through libobs
+	procedures_init();
+	profiler.Mark("background services");
 
 	// Check if loadout was specified via command line
 	if (!cmdLoadout.empty()) {
@@ -88,21 +237,27 @@ bool obs_module_load(void)
 
 		} else {
 			// Launch the applications provided by the given loadout
-			AutoStarter::LaunchPrograms(cmdLoadout.c_str());
+			LaunchInBackground(cmdLoadout);
 		}
 	} else {
-		// Check if the plugin is enabled
-		if (PluginConfig::Get().enabled) {
+		// Check if the plugin is enabled and the current loadout starts with OBS
+		Loadout *current = PluginConfig::Get().GetLoadout(
+			PluginConfig::Get().currentLoadout);
+		bool launchOnStartup =
+			!current || current->trigger == LaunchTrigger::Startup;
+		if (PluginConfig::Get().enabled && launchOnStartup) {
 			// Check if the plugin should ask to launch
 			if (PluginConfig::Get().askToLaunch) {
 				launch_widget_create();
 			} else {
 				// Launch the applications of the current loadout
-				AutoStarter::LaunchPrograms(
+				LaunchInBackground(
 					PluginConfig::Get().currentLoadout);
 			}
 		}
 	}
+	profiler.Mark("startup launch");
+	profiler.Report();
 	return true;
 }
 
@@ -115,9 +270,33 @@ bool obs_module_load(void)
  */
 void obs_module_unload(void)
 {
+	procedures_free();
+	output_triggers_free();
+	ResourceSampler::Stop();
+	// Nothing launches anymore once the programs are quit below
+	LaunchJob::Shutdown();
+
 	// Check if auto close is enabled
 	if (PluginConfig::Get().autoclose) {
 		// Quit all launched processes
 		AutoStarter::QuitPrograms();
+	} else {
+		// Stop sharing the programs that keep running
+		AutoStarter::ClearProcesses();
+	}
+	LaunchJournal::Flush();
+	StatusPage::Close();
+	LaunchRegistry::Close();
+	Supervisor::Stop();
+	OutputCapture::Stop();
+	PathIndex::Stop();
+	FileHandlers::Stop();
+
+	if (Trace::IsEnabled()) {
+		char *tracePath = obs_module_config_path("launch-trace.json");
+		if (tracePath) {
+			Trace::Write(tracePath);
+			bfree(tracePath);
+		}
 	}
 }
@@ -0,0 +1,176 @@
+// Checks configured programs in the background before they are launched
+#include <windows.h>
+#include "preflight.hpp"
+#include "config.hpp"
+#include "launch-plan.hpp"
+#include "integrity.hpp"
+#include <QThreadPool>
+#include "host.hpp"
+#include <atomic>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace {
+
+constexpr size_t BatchSize = 16;
+
+/**
+ * @brief Performs the expensive part of the check for a changed file.
+ */
+PreflightResult Inspect(const std::wstring &path, const std::string &sha256,
+			const WIN32_FILE_ATTRIBUTE_DATA &attributes)
+{
+	PreflightResult result;
+	if (attributes.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+		result.ok = false;
+		result.reason = "Path is a directory";
+		return result;
+	}
+
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ,
+				  FILE_SHARE_READ | FILE_SHARE_WRITE |
+					  FILE_SHARE_DELETE,
+				  nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+				  nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		result.ok = false;
+		result.reason = "File is not readable";
+		return result;
+	}
+
+	// Executables must carry a valid image header
+	size_t length = path.size();
+	bool isExecutable = length > 4 &&
+			    _wcsicmp(path.c_str() + length - 4, L".exe") == 0;
+	if (isExecutable) {
+		char header[2] = {};
+		DWORD bytesRead = 0;
+		if (!ReadFile(file, header, sizeof(header), &bytesRead,
+			      nullptr) ||
+		    bytesRead != sizeof(header) || header[0] != 'M' ||
+		    header[1] != 'Z') {
+			result.ok = false;
+			result.reason = "File is not a valid executable";
+		}
+	}
+	CloseHandle(file);
+
+	std::string digest;
+	if (result.ok && !sha256.empty() &&
+	    !Integrity::Verify(path, sha256, digest)) {
+		result.ok = false;
+		result.reason = digest.empty()
+					? "File could not be hashed"
+					: "File does not match its pinned SHA-256 " +
+						  digest;
+	}
+	return result;
+}
+
+} // namespace
+
+Preflight &Preflight::Get()
+{
+	static Preflight instance;
+	return instance;
+}
+
+void Preflight::Start()
+{
+	// Collect unique paths from the published plans, they are immutable
+	auto config = PluginConfig::Get().Snapshot();
+	std::map<std::wstring, std::string> uniquePaths;
+	for (const auto &[name, plan] : config->plans) {
+		for (const auto &program : plan->programs) {
+			std::string &sha256 = uniquePaths[program.fullPath];
+			if (sha256.empty())
+				sha256 = program.sha256;
+		}
+	}
+	if (uniquePaths.empty()) {
+		emit finished();
+		return;
+	}
+
+	// Hashing is slow, so every pinned program gets a batch of its own
+	std::vector<std::vector<Check>> batches;
+	std::vector<Check> unpinned;
+	for (const auto &check : uniquePaths) {
+		if (!check.second.empty()) {
+			batches.push_back({check});
+			continue;
+		}
+		unpinned.push_back(check);
+		if (unpinned.size() == BatchSize) {
+			batches.push_back(std::move(unpinned));
+			unpinned.clear();
+		}
+	}
+	if (!unpinned.empty())
+		batches.push_back(std::move(unpinned));
+
+	auto remaining = std::make_shared<std::atomic<size_t>>(batches.size());
+	for (auto &batch : batches) {
+		QThreadPool::globalInstance()->start(
+			[this, batch = std::move(batch), remaining]() {
+				CheckBatch(batch);
+				if (remaining->fetch_sub(1) == 1)
+					QMetaObject::invokeMethod(
+						this, [this]() { emit finished(); },
+						Qt::QueuedConnection);
+			});
+	}
+}
+
+void Preflight::CheckBatch(const std::vector<Check> &checks)
+{
+	for (const auto &[path, sha256] : checks) {
+		PreflightResult result;
+		WIN32_FILE_ATTRIBUTE_DATA attributes;
+		if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard,
+					  &attributes)) {
+			result.ok = false;
+			result.reason = "File not found";
+		} else {
+			uint64_t writeTime =
+				((uint64_t)attributes.ftLastWriteTime
+					 .dwHighDateTime
+				 << 32) |
+				attributes.ftLastWriteTime.dwLowDateTime;
+
+			// Unchanged files keep their previous verdict
+			{
+				std::lock_guard<std::mutex> lock(cacheMutex);
+				auto it = cache.find(path);
+				if (it != cache.end() &&
+				    it->second.writeTime == writeTime &&
+				    it->second.sha256 == sha256)
+					continue;
+			}
+
+			result = Inspect(path, sha256, attributes);
+			result.writeTime = writeTime;
+			result.sha256 = sha256;
+		}
+
+		if (!result.ok) {
+			Host::Log(Host::Warning, "Preflight: '%ls' - %s",
+				  path.c_str(), result.reason.c_str());
+		}
+
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		cache[path] = result;
+	}
+}
+
+bool Preflight::Lookup(const std::wstring &path, PreflightResult &result)
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	auto it = cache.find(path);
+	if (it == cache.end())
+		return false;
+
+	result = it->second;
+	return true;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <QObject>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Outcome of checking a single program path.
+ */
+struct PreflightResult {
+	bool ok = true;          ///< Whether the program can be launched
+	std::string reason;      ///< Why the program cannot be launched
+	uint64_t writeTime = 0;  ///< Last write time the verdict was based on
+	std::string sha256;      ///< Pinned digest the file was verified against, if any
+};
+
+/**
+ * @brief Validates every configured program in the background.
+ *
+ * Paths are checked in batches on the global thread pool. Programs with a
+ * pinned SHA-256 are hashed in their own task, so they are verified in
+ * parallel and warm the digest cache before launch. Verdicts are cached by
+ * path and last write time, so unchanged files only cost a single
+ * attribute query on later runs.
+ */
+class Preflight : public QObject {
+	Q_OBJECT
+public:
+	/**
+	 * @brief Retrieves the singleton instance of Preflight.
+	 */
+	static Preflight &Get();
+
+	/**
+	 * @brief Starts checking all programs of all loadouts. Must be called
+	 * on the UI thread.
+	 */
+	void Start();
+
+	/**
+	 * @brief Looks up the cached verdict for a program.
+	 * @param path Resolved absolute path of the program.
+	 * @param result Receives the verdict.
+	 * @return true if the path has been checked.
+	 */
+	bool Lookup(const std::wstring &path, PreflightResult &result);
+
+signals:
+	/**
+	 * @brief Emitted on the UI thread after a run has checked every path.
+	 */
+	void finished();
+
+private:
+	Preflight() = default;
+
+	std::mutex cacheMutex;
+	std::map<std::wstring, PreflightResult> cache;
+
+	/// Resolved path and pinned digest of a program
+	using Check = std::pair<std::wstring, std::string>;
+
+	void CheckBatch(const std::vector<Check> &checks);
+};
@@ -0,0 +1,142 @@
+/**
+ * @file procedures.cpp
+ * @brief Implementation of the libobs procedure and signal API
+ */
+
+#include "procedures.hpp"
+#include <obs-module.h>
+#include <callback/calldata.h>
+#include <callback/proc.h>
+#include <callback/signal.h>
+#include <atomic>
+#include "autostart.hpp"
+
+/// Cleared on unload, the procedure handler outlives the module
+static std::atomic<bool> active{false};
+
+static const char *signalDeclarations[] = {
+	"void autostarter_launched(string loadout, int index, string program, int pid)",
+	"void autostarter_failed(string loadout, int index, string program, int error)",
+	"void autostarter_exited(string loadout, int index, int pid, int exit_code)",
+	nullptr,
+};
+
+static void LaunchProc(void *, calldata_t *cd)
+{
+	const char *loadout = calldata_string(cd, "loadout");
+	bool success = active && loadout && *loadout &&
+		       AutoStarter::LaunchPrograms(loadout);
+	calldata_set_bool(cd, "success", success);
+}
+
+static void QuitProc(void *, calldata_t *cd)
+{
+	const char *loadout = calldata_string(cd, "loadout");
+	bool success = active && loadout &&
+		       AutoStarter::QuitLoadout(loadout);
+	calldata_set_bool(cd, "success", success);
+}
+
+static void FreezeProc(void *, calldata_t *cd)
+{
+	const char *loadout = calldata_string(cd, "loadout");
+	bool success = active && loadout &&
+		       AutoStarter::SetLoadoutFrozen(
+			       loadout, calldata_bool(cd, "frozen"));
+	calldata_set_bool(cd, "success", success);
+}
+
+static void StatusProc(void *, calldata_t *cd)
+{
+	const char *loadout = calldata_string(cd, "loadout");
+	bool frozen = false;
+	long long running = 0;
+	if (active && loadout) {
+		AutoStarter::ForEachProcess(
+			[&](const LaunchedProcess &process) {
+				if (process.loadout->name != loadout)
+					return;
+				running++;
+				frozen = frozen || process.frozen;
+			});
+	}
+	calldata_set_bool(cd, "launched", running > 0);
+	calldata_set_bool(cd, "frozen", frozen);
+	calldata_set_int(cd, "running", running);
+}
+
+void procedures_init()
+{
+	proc_handler_t *procs = obs_get_proc_handler();
+	proc_handler_add(procs,
+			 "void autostarter_launch(in string loadout, out bool success)",
+			 LaunchProc, nullptr);
+	proc_handler_add(procs,
+			 "void autostarter_quit(in string loadout, out bool success)",
+			 QuitProc, nullptr);
+	proc_handler_add(procs,
+			 "void autostarter_freeze(in string loadout, in bool frozen, out bool success)",
+			 FreezeProc, nullptr);
+	proc_handler_add(procs,
+			 "void autostarter_status(in string loadout, out bool launched, out bool frozen, out int running)",
+			 StatusProc, nullptr);
+
+	signal_handler_add_array(obs_get_signal_handler(), signalDeclarations);
+	active = true;
+}
+
+void procedures_free()
+{
+	active = false;
+}
+
+void procedures_signal_launched(const char *loadout, size_t index,
+				const char *program, unsigned long processId)
+{
+	if (!active)
+		return;
+
+	calldata_t cd;
+	calldata_init(&cd);
+	calldata_set_string(&cd, "loadout", loadout);
+	calldata_set_int(&cd, "index", (long long)index);
+	calldata_set_string(&cd, "program", program);
+	calldata_set_int(&cd, "pid", processId);
+	signal_handler_signal(obs_get_signal_handler(), "autostarter_launched",
+			      &cd);
+	calldata_free(&cd);
+}
+
+void procedures_signal_failed(const char *loadout, size_t index,
+			      const char *program, unsigned long errorCode)
+{
+	if (!active)
+		return;
+
+	calldata_t cd;
+	calldata_init(&cd);
+	calldata_set_string(&cd, "loadout", loadout);
+	calldata_set_int(&cd, "index", (long long)index);
+	calldata_set_string(&cd, "program", program);
+	calldata_set_int(&cd, "error", errorCode);
+	signal_handler_signal(obs_get_signal_handler(), "autostarter_failed",
+			      &cd);
+	calldata_free(&cd);
+}
+
+void procedures_signal_exited(const char *loadout, size_t index,
+			      unsigned long processId, unsigned long exitCode)
+{
+	if (!active)
+		return;
+
+	calldata_t cd;
+	calldata_init(&cd);
+	calldata_set_string(&cd, "loadout", loadout);
+	calldata_set_int(&cd, "index", (long long)index);
+	calldata_set_int(&cd, "pid", processId);
+	calldata_set_int(&cd, "exit_code", exitCode);
+	signal_handler_signal(obs_get_signal_handler(), "autostarter_exited",
+			      &cd);
+	calldata_free(&cd);
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+
+/**
+ * @file procedures.hpp
+ * @brief Exposes Autostarter to other plugins through libobs
+ *
+ * Procedures on the global procedure handler, all taking the loadout name
+ * as `in string loadout`:
+ * - `autostarter_launch`: launches a loadout, blocking until its programs
+ *   are started. Returns `out bool success`.
+ * - `autostarter_quit`: quits a loadout. Returns `out bool success`.
+ * - `autostarter_freeze`: suspends or resumes a loadout according to
+ *   `in bool frozen`. Returns `out bool success`.
+ * - `autostarter_status`: returns `out bool launched`, `out bool frozen`
+ *   and `out int running`, the number of tracked programs.
+ *
+ * Signals on the global signal handler:
+ * - `autostarter_launched(string loadout, int index, string program, int pid)`
+ * - `autostarter_failed(string loadout, int index, string program, int error)`
+ * - `autostarter_exited(string loadout, int index, int pid, int exit_code)`,
+ *   sent when a tracked program ends by itself
+ *
+ * Procedures call straight into AutoStarter on the calling thread.
+ * `autostarter_launched` and `autostarter_failed` are sent from the thread
+ * that launched the program, `autostarter_exited` from the UI thread, so
+ * handlers may call the procedures.
+ */
+
+/**
+ * @brief Registers the procedures and declares the signals
+ */
+void procedures_init();
+
+/**
+ * @brief Makes later procedure calls fail, libobs cannot remove them
+ */
+void procedures_free();
+
+/**
+ * @brief Sends autostarter_launched
+ */
+void procedures_signal_launched(const char *loadout, size_t index,
+				const char *program, unsigned long processId);
+
+/**
+ * @brief Sends autostarter_failed
+ */
+void procedures_signal_failed(const char *loadout, size_t index,
+			      const char *program, unsigned long errorCode);
+
+/**
+ * @brief Sends autostarter_exited
+ */
+void procedures_signal_exited(const char *loadout, size_t index,
+			      unsigned long processId, unsigned long exitCode);
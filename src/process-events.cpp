@@ -0,0 +1,155 @@
+// Delivers process start and exit events to the UI in coalesced batches
+#include <windows.h>
+#include "process-events.hpp"
+#include "constants.hpp"
+#include "status-page.hpp"
+#include "host.hpp"
+
+struct ProcessWatch {
+	ProcessStatus status;
+	HANDLE process = nullptr; ///< Owned by the caller, open until Unwatch()
+	HANDLE waitHandle = nullptr;
+
+	/**
+	 * @brief Runs on a thread pool thread once the process has exited.
+	 * The watch stays valid until Unwatch() returns.
+	 */
+	static VOID CALLBACK OnExited(PVOID context, BOOLEAN)
+	{
+		auto watch = static_cast<ProcessWatch *>(context);
+		ProcessStatus status = watch->status;
+		status.running = false;
+		StatusPage::Stopped(status.processId);
+
+		// Listeners may call back into AutoStarter, which waits for this
+		// callback in Unwatch(), so they are notified with the batch
+		DWORD exitCode = 0;
+		GetExitCodeProcess(watch->process, &exitCode);
+		ProcessEvents::Get().Post(status, &exitCode);
+	}
+};
+
+ProcessEvents &ProcessEvents::Get()
+{
+	static ProcessEvents instance;
+	return instance;
+}
+
+ProcessEvents::ProcessEvents()
+{
+	batchTimer = new QTimer(this);
+	batchTimer->setSingleShot(true);
+	batchTimer->setInterval(Constants::STATUS_BATCH_INTERVAL_MS);
+	connect(batchTimer, &QTimer::timeout, this, &ProcessEvents::Flush);
+}
+
+ProcessWatch *ProcessEvents::Watch(HANDLE process, const std::string &loadout,
+				   size_t index, const std::wstring &path)
+{
+	auto watch = new ProcessWatch();
+	watch->status.loadout = loadout;
+	watch->status.index = index;
+	watch->status.path = path;
+	watch->status.running = true;
+	watch->status.processId = GetProcessId(process);
+	watch->process = process;
+
+	FILETIME creationTime, exitTime, kernelTime, userTime;
+	if (GetProcessTimes(process, &creationTime, &exitTime, &kernelTime,
+			    &userTime))
+		watch->status.startTime =
+			((uint64_t)creationTime.dwHighDateTime << 32) |
+			creationTime.dwLowDateTime;
+
+	Post(watch->status);
+
+	if (!RegisterWaitForSingleObject(&watch->waitHandle, process,
+					 ProcessWatch::OnExited, watch, INFINITE,
+					 WT_EXECUTEONLYONCE)) {
+		Host::Log(Host::Warning,
+			  "Failed to watch process %lu, error code: %lu",
+			  watch->status.processId, GetLastError());
+		delete watch;
+		return nullptr;
+	}
+	return watch;
+}
+
+void ProcessEvents::Unwatch(ProcessWatch *watch)
+{
+	if (!watch)
+		return;
+
+	// Blocks until a running callback has returned
+	UnregisterWaitEx(watch->waitHandle, INVALID_HANDLE_VALUE);
+	watch->status.running = false;
+	Post(watch->status);
+	delete watch;
+}
+
+uint64_t ProcessEvents::UptimeSeconds(uint64_t startTime)
+{
+	// FILETIME ticks are 100 ns
+	FILETIME now;
+	GetSystemTimeAsFileTime(&now);
+	uint64_t nowTicks = ((uint64_t)now.dwHighDateTime << 32) |
+			    now.dwLowDateTime;
+	return startTime && nowTicks > startTime
+		       ? (nowTicks - startTime) / 10000000
+		       : 0;
+}
+
+bool ProcessEvents::Lookup(const std::string &loadout,
+			   const std::wstring &path, ProcessStatus &status)
+{
+	std::lock_guard<std::mutex> lock(statusMutex);
+	auto it = statuses.find({loadout, path});
+	if (it == statuses.end())
+		return false;
+
+	status = it->second;
+	return true;
+}
+
+void ProcessEvents::Post(const ProcessStatus &status,
+			 const unsigned long *exitCode)
+{
+	{
+		std::lock_guard<std::mutex> lock(statusMutex);
+		auto key = std::make_pair(status.loadout, status.path);
+		statuses[key] = status;
+		// Later changes of the same program replace earlier ones
+		pending[key] = status;
+		if (exitCode)
+			exits.push_back({status, *exitCode});
+		if (flushScheduled)
+			return;
+		flushScheduled = true;
+	}
+
+	// The timer lives on the UI thread
+	QMetaObject::invokeMethod(
+		this, [this]() { batchTimer->start(); }, Qt::QueuedConnection);
+}
+
+void ProcessEvents::Flush()
+{
+	std::vector<ProcessStatus> changes;
+	std::vector<Exit> exited;
+	{
+		std::lock_guard<std::mutex> lock(statusMutex);
+		changes.reserve(pending.size());
+		for (auto &[key, status] : pending)
+			changes.push_back(std::move(status));
+		pending.clear();
+		exited.swap(exits);
+		flushScheduled = false;
+	}
+
+	for (const auto &exit : exited)
+		Host::ProgramExited(exit.status.loadout.c_str(),
+				    exit.status.index, exit.status.processId,
+				    exit.exitCode);
+	if (!changes.empty())
+		emit statusChanged(changes);
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <QObject>
+#include <QTimer>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Forward declare Windows types
+using HANDLE = void *;
+
+/**
+ * @brief Current state of one program of a loadout.
+ */
+struct ProcessStatus {
+	std::string loadout;         ///< Name of the loadout the program was launched from
+	size_t index = 0;            ///< Index of the program within the loadout plan
+	std::wstring path;           ///< Resolved path of the program, identifies it in the UI
+	bool running = false;        ///< Whether the process is alive
+	unsigned long processId = 0; ///< Process ID, 0 if it never ran
+	uint64_t startTime = 0;      ///< Process creation time as FILETIME ticks
+};
+
+/**
+ * @brief Token returned by ProcessEvents::Watch().
+ */
+struct ProcessWatch;
+
+/**
+ * @brief Pushes process state changes from the launcher to the UI thread.
+ *
+ * Processes are watched with RegisterWaitForSingleObject, so exits are
+ * reported without polling. Changes posted from any thread are coalesced
+ * per program and delivered as one batch per
+ * Constants::STATUS_BATCH_INTERVAL_MS on the UI thread. Exits are reported
+ * to the host with the batch too, never from the wait callback.
+ */
+class ProcessEvents : public QObject {
+	Q_OBJECT
+public:
+	/**
+	 * @brief Retrieves the singleton instance. Must first be called on the UI thread.
+	 */
+	static ProcessEvents &Get();
+
+	/**
+	 * @brief Reports a program as running and watches it for its exit.
+	 * @param process Process handle, must stay open until Unwatch().
+	 * @param loadout Name of the loadout the program was launched from.
+	 * @param index Index of the program within the loadout plan.
+	 * @param path Resolved path of the program.
+	 * @return Token for Unwatch(), nullptr if the process cannot be watched.
+	 */
+	ProcessWatch *Watch(HANDLE process, const std::string &loadout,
+			    size_t index, const std::wstring &path);
+
+	/**
+	 * @brief Stops watching a process and reports it as stopped.
+	 *
+	 * Waits for a running exit notification to finish, so the process
+	 * handle may be closed afterwards.
+	 * @param watch Token from Watch(), may be nullptr.
+	 */
+	void Unwatch(ProcessWatch *watch);
+
+	/**
+	 * @brief Looks up the last known state of a program.
+	 * @param loadout Name of the loadout.
+	 * @param path Resolved path of the program.
+	 * @param status Receives the state.
+	 * @return true if the program has been launched in this session.
+	 */
+	bool Lookup(const std::string &loadout, const std::wstring &path,
+		    ProcessStatus &status);
+
+	/**
+	 * @brief Returns the seconds that passed since a process was created.
+	 * @param startTime Creation time as FILETIME ticks, see ProcessStatus.
+	 */
+	static uint64_t UptimeSeconds(uint64_t startTime);
+
+signals:
+	/**
+	 * @brief Emitted on the UI thread with every program that changed since the last batch.
+	 */
+	void statusChanged(const std::vector<ProcessStatus> &changes);
+
+private:
+	friend struct ProcessWatch;
+
+	ProcessEvents();
+
+	std::mutex statusMutex;
+	std::map<std::pair<std::string, std::wstring>, ProcessStatus> statuses;
+	std::map<std::pair<std::string, std::wstring>, ProcessStatus> pending;
+
+	/**
+	 * @brief A program that ended by itself, reported to the host on flush.
+	 */
+	struct Exit {
+		ProcessStatus status;
+		unsigned long exitCode;
+	};
+	std::vector<Exit> exits; ///< Not coalesced, every exit is reported
+
+	bool flushScheduled = false;
+	QTimer *batchTimer;
+
+	void Post(const ProcessStatus &status,
+		  const unsigned long *exitCode = nullptr);
+	void Flush();
+};
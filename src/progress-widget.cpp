@@ -0,0 +1,92 @@
+#include "progress-widget.hpp"
+#include <QVBoxLayout>
+#include <QTimer>
+
+namespace {
+
+QString StatusText(LaunchJob::Status status)
+{
+	switch (status) {
+	case LaunchJob::Status::Queued:
+		return "Queued";
+	case LaunchJob::Status::Spawning:
+		return "Starting...";
+	case LaunchJob::Status::Running:
+		return "Running";
+	case LaunchJob::Status::Failed:
+		return "Failed";
+	}
+	return QString();
+}
+
+} // namespace
+
+LaunchProgressWidget::LaunchProgressWidget(LaunchJob *job, QWidget *parent)
+	: QWidget(parent)
+{
+	setWindowTitle("Autostarter");
+	setWindowFlags(windowFlags() | Qt::WindowStaysOnTopHint);
+	setAttribute(Qt::WA_DeleteOnClose);
+
+	auto mainLayout = new QVBoxLayout(this);
+
+	titleLabel = new QLabel(
+		"Launching " + QString::fromStdString(job->plan().name) +
+			"...",
+		this);
+	mainLayout->addWidget(titleLabel);
+
+	// One row per program, in plan order so job indices map to rows
+	programsList = new QListWidget(this);
+	for (const auto &program : job->plan().programs) {
+		QString name = QString::fromStdString(program.displayName);
+		auto item = new QListWidgetItem(
+			name + ": " + StatusText(LaunchJob::Status::Queued),
+			programsList);
+		item->setData(Qt::UserRole, name);
+	}
+	mainLayout->addWidget(programsList);
+
+	closeButton = new QPushButton("Close", this);
+	mainLayout->addWidget(closeButton);
+
+	connect(closeButton, &QPushButton::clicked, this, &QWidget::close);
+	connect(job, &LaunchJob::programStatusChanged, this,
+		&LaunchProgressWidget::onProgramStatusChanged);
+	connect(job, &LaunchJob::finished, this,
+		&LaunchProgressWidget::onFinished);
+
+	resize(300, 250);
+}
+
+void LaunchProgressWidget::ShowProgress(LaunchJob *job)
+{
+	auto widget = new LaunchProgressWidget(job);
+	widget->show();
+	job->start();
+}
+
+void LaunchProgressWidget::onProgramStatusChanged(int index,
+						  LaunchJob::Status status,
+						  const QString &reason)
+{
+	auto item = programsList->item(index);
+	if (!item)
+		return;
+
+	QString name = item->data(Qt::UserRole).toString();
+	QString statusText = StatusText(status);
+	if (!reason.isEmpty())
+		statusText += " (" + reason + ")";
+	item->setText(name + ": " + statusText);
+}
+
+void LaunchProgressWidget::onFinished(bool success)
+{
+	if (success) {
+		titleLabel->setText("All programs are running");
+		QTimer::singleShot(1500, this, &QWidget::close);
+	} else {
+		titleLabel->setText("Some programs failed to launch");
+	}
+}
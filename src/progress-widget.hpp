@@ -0,0 +1,45 @@
+#pragma once
+#include <QtWidgets/QWidget>
+#include <QLabel>
+#include <QListWidget>
+#include <QPushButton>
+#include "launch-job.hpp"
+
+/**
+ * @brief Non-blocking window that shows the progress of a launch job.
+ *
+ * Each program of the loadout gets a row that is updated as the job
+ * reports status changes.
+ */
+class LaunchProgressWidget : public QWidget {
+	Q_OBJECT
+public:
+	/**
+	 * @brief Constructs the progress window and connects it to the job.
+	 * @param job The job to follow. Must not have been started yet.
+	 * @param parent Parent widget pointer.
+	 */
+	explicit LaunchProgressWidget(LaunchJob *job, QWidget *parent = nullptr);
+
+	/**
+	 * @brief Shows a progress window for the job and starts it.
+	 * @param job The job to follow and start.
+	 */
+	static void ShowProgress(LaunchJob *job);
+
+private slots:
+	/**
+	 * @brief Updates the row of the program whose status changed.
+	 */
+	void onProgramStatusChanged(int index, LaunchJob::Status status,
+				    const QString &reason);
+	/**
+	 * @brief Shows the final result and closes the window on success.
+	 */
+	void onFinished(bool success);
+
+private:
+	QLabel *titleLabel;
+	QListWidget *programsList;
+	QPushButton *closeButton;
+};
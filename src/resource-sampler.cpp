@@ -0,0 +1,235 @@
+// Samples resource usage of the programs launched by AutoStarter
+#include <windows.h>
+#include <psapi.h>
+#include "resource-sampler.hpp"
+#include "autostart.hpp"
+#include "config.hpp"
+#include <obs-module.h>
+#include <algorithm>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using ProgramKey = std::pair<std::string, std::wstring>;
+
+/**
+ * @brief Per-process counters carried from one sample to the next.
+ */
+struct ProcessState {
+	uint64_t creationTime = 0; ///< Detects reuse of a closed handle value
+	uint64_t cpuTime = 0;      ///< Kernel + user time at the previous sample
+	uint64_t wallTime = 0;     ///< System time at the previous sample
+	bool seen = false;         ///< Whether the process was seen this round
+	bool cpuWarned = false;    ///< CPU threshold warning already logged
+	bool memoryWarned = false; ///< Memory threshold warning already logged
+};
+
+std::thread samplerThread;
+std::mutex stopMutex;
+std::condition_variable stopCondition;
+bool stopRequested = false;
+
+/**
+ * @brief History of a program and the sampling round that last updated it.
+ */
+struct TrackedHistory {
+	ResourceHistory history;
+	uint64_t round = 0;
+};
+
+/**
+ * @brief A threshold a program went over, logged once the process list is
+ * unlocked.
+ */
+struct Breach {
+	std::string name;
+	bool cpu; ///< CPU if true, memory otherwise
+	ResourceSample sample;
+};
+
+std::mutex historyMutex;
+std::map<ProgramKey, TrackedHistory> histories;
+uint64_t sampleRound = 0; ///< Only touched by the sampler thread
+
+// Only touched by the sampler thread
+std::map<HANDLE, ProcessState> states;
+
+uint64_t ToUInt64(const FILETIME &time)
+{
+	return ((uint64_t)time.dwHighDateTime << 32) | time.dwLowDateTime;
+}
+
+/**
+ * @brief Collects the thresholds a process newly went over. Runs while the
+ * process list is locked, so it only records them.
+ */
+void CheckThresholds(const LaunchedProcess &process, ProcessState &state,
+		     const ResourceSample &sample, double cpuThreshold,
+		     uint64_t memoryThreshold, std::vector<Breach> &breaches)
+{
+	const std::string &name =
+		process.loadout->programs[process.index].displayName;
+
+	bool cpuHigh = cpuThreshold > 0.0 && sample.cpuPercent > cpuThreshold;
+	if (cpuHigh && !state.cpuWarned)
+		breaches.push_back({name, true, sample});
+	state.cpuWarned = cpuHigh;
+
+	bool memoryHigh = memoryThreshold > 0 &&
+			  sample.workingSetBytes > memoryThreshold;
+	if (memoryHigh && !state.memoryWarned)
+		breaches.push_back({name, false, sample});
+	state.memoryWarned = memoryHigh;
+}
+
+void SampleProcesses(double cpuThreshold, uint64_t memoryThreshold)
+{
+	FILETIME now;
+	GetSystemTimeAsFileTime(&now);
+	uint64_t wallTime = ToUInt64(now);
+	unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+
+	for (auto &entry : states)
+		entry.second.seen = false;
+
+	std::vector<std::pair<ProgramKey, ResourceSample>> results;
+	std::vector<Breach> breaches;
+	AutoStarter::ForEachProcess([&](const LaunchedProcess &process) {
+		FILETIME creation, exit, kernel, user;
+		if (!GetProcessTimes(process.handle, &creation, &exit, &kernel,
+				     &user))
+			return;
+
+		ResourceSample sample;
+		PROCESS_MEMORY_COUNTERS memory = {sizeof(memory)};
+		if (GetProcessMemoryInfo(process.handle, &memory,
+					 sizeof(memory)))
+			sample.workingSetBytes = memory.WorkingSetSize;
+		IO_COUNTERS io;
+		if (GetProcessIoCounters(process.handle, &io)) {
+			sample.readBytes = io.ReadTransferCount;
+			sample.writeBytes = io.WriteTransferCount;
+		}
+
+		uint64_t cpuTime = ToUInt64(kernel) + ToUInt64(user);
+		ProcessState &state = states[process.handle];
+		if (state.creationTime == ToUInt64(creation) &&
+		    wallTime > state.wallTime) {
+			sample.cpuPercent =
+				100.0 * (double)(cpuTime - state.cpuTime) /
+				((double)(wallTime - state.wallTime) * cores);
+			CheckThresholds(process, state, sample, cpuThreshold,
+					memoryThreshold, breaches);
+		} else {
+			state = ProcessState();
+			state.creationTime = ToUInt64(creation);
+		}
+		state.cpuTime = cpuTime;
+		state.wallTime = wallTime;
+		state.seen = true;
+
+		results.push_back(
+			{{process.loadout->name, process.path}, sample});
+	});
+
+	// Forget processes that are no longer tracked
+	for (auto it = states.begin(); it != states.end();) {
+		it = it->second.seen ? std::next(it) : states.erase(it);
+	}
+
+	for (const auto &breach : breaches) {
+		if (breach.cpu)
+			blog(LOG_WARNING,
+			     "'%s' uses %.1f%% CPU (threshold %.1f%%)",
+			     breach.name.c_str(), breach.sample.cpuPercent,
+			     cpuThreshold);
+		else
+			blog(LOG_WARNING,
+			     "'%s' uses %llu MB of memory (threshold %llu MB)",
+			     breach.name.c_str(),
+			     breach.sample.workingSetBytes / (1024 * 1024),
+			     memoryThreshold / (1024 * 1024));
+	}
+
+	// Update the histories in place, dropping those of programs that are
+	// no longer tracked
+	sampleRound++;
+	std::lock_guard<std::mutex> lock(historyMutex);
+	for (auto &[key, sample] : results) {
+		TrackedHistory &tracked = histories[key];
+		tracked.round = sampleRound;
+
+		ResourceHistory &history = tracked.history;
+		history.samples[history.next] = sample;
+		history.next = (history.next + 1) % history.samples.size();
+		history.count = std::min(history.count + 1,
+					 history.samples.size());
+	}
+	for (auto it = histories.begin(); it != histories.end();) {
+		it = it->second.round == sampleRound ? std::next(it)
+						     : histories.erase(it);
+	}
+}
+
+void SamplerLoop()
+{
+	std::unique_lock<std::mutex> lock(stopMutex);
+	while (!stopCondition.wait_for(
+		lock, std::chrono::milliseconds(Constants::SAMPLE_INTERVAL_MS),
+		[] { return stopRequested; })) {
+		auto config = PluginConfig::Get().Snapshot();
+		double cpuThreshold = config->cpuWarningPercent;
+		uint64_t memoryThreshold =
+			(uint64_t)config->memoryWarningMB * 1024 * 1024;
+
+		lock.unlock();
+		SampleProcesses(cpuThreshold, memoryThreshold);
+		lock.lock();
+	}
+}
+
+} // namespace
+
+void ResourceSampler::Start()
+{
+	if (samplerThread.joinable())
+		return;
+
+	stopRequested = false;
+	samplerThread = std::thread(SamplerLoop);
+}
+
+void ResourceSampler::Stop()
+{
+	if (!samplerThread.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(stopMutex);
+		stopRequested = true;
+	}
+	stopCondition.notify_all();
+	samplerThread.join();
+
+	states.clear();
+	std::lock_guard<std::mutex> lock(historyMutex);
+	histories.clear();
+}
+
+bool ResourceSampler::GetHistory(const std::string &loadoutName,
+				 const std::wstring &path,
+				 ResourceHistory &history)
+{
+	std::lock_guard<std::mutex> lock(historyMutex);
+	auto it = histories.find({loadoutName, path});
+	if (it == histories.end() || it->second.history.count == 0)
+		return false;
+
+	history = it->second.history;
+	return true;
+}
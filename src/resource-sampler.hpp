@@ -0,0 +1,63 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include "constants.hpp"
+
+/**
+ * @brief Resource usage of a launched program at one point in time.
+ */
+struct ResourceSample {
+	double cpuPercent = 0.0;      ///< CPU usage across all cores since the previous sample
+	uint64_t workingSetBytes = 0; ///< Resident memory (working set)
+	uint64_t readBytes = 0;       ///< Total bytes read since the process started
+	uint64_t writeBytes = 0;      ///< Total bytes written since the process started
+};
+
+/**
+ * @brief Fixed-size history of samples for a single program.
+ */
+struct ResourceHistory {
+	std::array<ResourceSample, Constants::SAMPLE_HISTORY_SIZE> samples; ///< Ring buffer of samples
+	size_t next = 0;  ///< Slot the next sample is written to
+	size_t count = 0; ///< Number of valid samples
+
+	/**
+	 * @brief Returns the most recent sample. Only valid if count > 0.
+	 */
+	const ResourceSample &Latest() const
+	{
+		return samples[(next + samples.size() - 1) % samples.size()];
+	}
+};
+
+/**
+ * @brief Periodically samples CPU, memory and I/O of the processes tracked
+ * by AutoStarter on a background thread.
+ *
+ * The process handles AutoStarter already holds are reused for every
+ * sample, so no handles are opened and each process costs three calls.
+ */
+class ResourceSampler {
+public:
+	/**
+	 * @brief Starts the background sampling thread.
+	 */
+	static void Start();
+
+	/**
+	 * @brief Stops the background sampling thread and clears all history.
+	 */
+	static void Stop();
+
+	/**
+	 * @brief Retrieves the sample history of a program.
+	 * @param loadoutName The loadout the program was launched from.
+	 * @param path Resolved path of the program.
+	 * @param history Receives a copy of the history.
+	 * @return true if the program is tracked and has been sampled.
+	 */
+	static bool GetHistory(const std::string &loadoutName,
+			       const std::wstring &path,
+			       ResourceHistory &history);
+};
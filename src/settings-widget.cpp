@@ -2,6 +2,14 @@
 #include "config.hpp"
 #include "autostart.hpp"
 #include "constants.hpp"
+#include "progress-widget.hpp"
+#include "resource-sampler.hpp"
+#include "output-capture.hpp"
+#include "preflight.hpp"
+#include "process-events.hpp"
+#include "launch-plan.hpp"
+#include "supervisor.hpp"
+#include "output-triggers.hpp"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QFileDialog>
@@ -12,8 +20,10 @@
 #include <QDialog>
 #include <QMessageBox>
 #include <QLineEdit>
+#include <QSignalBlocker>
 
 ProgramListItem::ProgramListItem(const QString &path, bool minimized,
+				 bool captureOutput, const QString &logPath,
 				 QWidget *parent)
 	: QWidget(parent), fullPath(path)
 {
@@ -26,21 +36,124 @@ ProgramListItem::ProgramListItem(const QString &path, bool minimized,
 	pathLabel->setToolTip(path);
 	pathLabel->setAlignment(Qt::AlignVCenter);
 
+	usageLabel = new QLabel(this);
+	usageLabel->setAlignment(Qt::AlignVCenter);
+
+	statusLabel = new QLabel(this);
+	statusLabel->setAlignment(Qt::AlignVCenter);
+
 	auto minimizedLabel = new QLabel("| Minimized?", this);
 	minimizedLabel->setAlignment(Qt::AlignVCenter);
 
 	minimizedBox = new QCheckBox(this);
 	minimizedBox->setChecked(minimized);
 
+	auto captureLabel = new QLabel("| Log?", this);
+	captureLabel->setAlignment(Qt::AlignVCenter);
+
+	captureBox = new QCheckBox(this);
+	captureBox->setChecked(captureOutput);
+	captureBox->setToolTip("Write the program's output to a log file");
+
+	logButton = new QPushButton("Log", this);
+	logButton->setMaximumWidth(40);
+	logButton->setToolTip("Open the program's output log");
+	logButton->setEnabled(QFileInfo(logPath).exists());
+	connect(logButton, &QPushButton::clicked, this, [logPath]() {
+		QDesktopServices::openUrl(QUrl::fromLocalFile(logPath));
+	});
+
 	layout->addWidget(pathLabel);
 	layout->addStretch();
+	layout->addWidget(statusLabel);
+	layout->addWidget(usageLabel);
 	layout->addWidget(minimizedLabel);
 	layout->addWidget(minimizedBox);
+	layout->addWidget(captureLabel);
+	layout->addWidget(captureBox);
+	layout->addWidget(logButton);
+}
+
+void ProgramListItem::setUsage(const ResourceSample *sample)
+{
+	if (!sample) {
+		usageLabel->clear();
+		return;
+	}
+
+	usageLabel->setText(
+		QString("%1% | %2 MB")
+			.arg(sample->cpuPercent, 0, 'f', 1)
+			.arg(sample->workingSetBytes / (1024 * 1024)));
+}
+
+void ProgramListItem::setStatus(const ProcessStatus *status)
+{
+	if (!status) {
+		running = false;
+		statusLabel->clear();
+		return;
+	}
+
+	running = status->running;
+	processId = status->processId;
+	startTime = status->startTime;
+	if (!running) {
+		statusLabel->setStyleSheet("color: gray;");
+		statusLabel->setText("Stopped");
+		statusLabel->setToolTip(QString());
+		return;
+	}
+
+	statusLabel->setStyleSheet("color: green;");
+	statusLabel->setToolTip(QString("PID %1").arg(processId));
+	refreshUptime();
+}
+
+void ProgramListItem::refreshUptime()
+{
+	if (!running)
+		return;
+
+	uint64_t seconds = ProcessEvents::UptimeSeconds(startTime);
+
+	QString uptime = seconds >= 3600
+				 ? QString("%1h %2m")
+					   .arg(seconds / 3600)
+					   .arg(seconds / 60 % 60)
+				 : QString("%1m %2s")
+					   .arg(seconds / 60)
+					   .arg(seconds % 60);
+	statusLabel->setText(
+		QString("Running %1 | PID %2").arg(uptime).arg(processId));
+}
+
+void ProgramListItem::setProblem(const QString &reason)
+{
+	if (reason.isEmpty()) {
+		pathLabel->setStyleSheet("");
+		pathLabel->setToolTip(fullPath);
+		return;
+	}
+
+	pathLabel->setStyleSheet("color: red;");
+	pathLabel->setToolTip(fullPath + "\n" + reason);
 }
 
 SettingsWidget *settings_instance = nullptr;
 
-SettingsWidget::SettingsWidget(QWidget *parent) : QWidget(parent)
+/**
+ * @brief Returns the path shown for a program, bare command names are shown as is.
+ */
+static QString ProgramDisplayPath(const Program &program)
+{
+	if (program.path.empty())
+		return QString::fromStdString(program.executable);
+	return QString::fromStdString(program.path + "/" + program.executable);
+}
+
+SettingsWidget::SettingsWidget(QWidget *parent)
+	: QWidget(parent), draft(PluginConfig::Get())
 {
 	// Initialize and set up the main configuration window layout
 	settings_instance = this;
@@ -69,8 +182,7 @@ SettingsWidget::SettingsWidget(QWidget *parent) : QWidget(parent)
 	loadoutLayout->addWidget(removeLoadoutButton);
 	mainLayout->addLayout(loadoutLayout);
 
-	auto &config = PluginConfig::Get();
-	for (const auto &loadout : config.loadouts) {
+	for (const auto &loadout : draft.loadouts) {
 		loadoutCombo->addItem(QString::fromStdString(loadout.name));
 	}
 
@@ -82,6 +194,41 @@ SettingsWidget::SettingsWidget(QWidget *parent) : QWidget(parent)
 	connect(removeLoadoutButton, &QPushButton::clicked, this,
 		&SettingsWidget::onRemoveLoadoutClicked);
 
+	auto triggerLayout = new QHBoxLayout();
+	triggerCombo = new QComboBox(this);
+	triggerCombo->addItem("OBS startup", (int)LaunchTrigger::Startup);
+	triggerCombo->addItem("Streaming", (int)LaunchTrigger::Streaming);
+	triggerCombo->addItem("Recording", (int)LaunchTrigger::Recording);
+	triggerCombo->addItem("Replay buffer",
+			      (int)LaunchTrigger::ReplayBuffer);
+	freezeCheckbox = new QCheckBox("Freeze when idle", this);
+	freezeCheckbox->setToolTip(
+		"Suspend the programs while OBS is not streaming or recording");
+	triggerLayout->addWidget(new QLabel("Launch on:", this));
+	triggerLayout->addWidget(triggerCombo);
+	triggerLayout->addWidget(freezeCheckbox);
+	mainLayout->addLayout(triggerLayout);
+
+	auto includesLayout = new QHBoxLayout();
+	includesEdit = new QLineEdit(this);
+	includesEdit->setPlaceholderText("Other loadouts, comma separated");
+	includesEdit->setToolTip(
+		"The programs of these loadouts are launched as well");
+	includesLayout->addWidget(new QLabel("Includes:", this));
+	includesLayout->addWidget(includesEdit);
+	mainLayout->addLayout(includesLayout);
+
+	stateLabel = new QLabel(this);
+	mainLayout->addWidget(stateLabel);
+
+	connect(triggerCombo,
+		QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+		&SettingsWidget::onTriggerChanged);
+	connect(freezeCheckbox, &QCheckBox::toggled, this,
+		&SettingsWidget::onFreezeToggled);
+	connect(includesEdit, &QLineEdit::editingFinished, this,
+		&SettingsWidget::onIncludesEdited);
+
 	programsList = new QListWidget(this);
 	mainLayout->addWidget(programsList);
 
@@ -99,6 +246,10 @@ SettingsWidget::SettingsWidget(QWidget *parent) : QWidget(parent)
 	autocloseCheckbox = new QCheckBox("Autoclose (only for .exe)", this);
 	checkboxLayout->addWidget(askToLaunchCheckbox);
 	checkboxLayout->addWidget(autocloseCheckbox);
+	quitRecoveredCheckbox = new QCheckBox("Quit after crash", this);
+	quitRecoveredCheckbox->setToolTip(
+		"Quit programs that are still running after OBS crashed instead of tracking them again");
+	checkboxLayout->addWidget(quitRecoveredCheckbox);
 	mainLayout->addLayout(checkboxLayout);
 
     mainLayout->addSpacing(10);
@@ -106,7 +257,11 @@ SettingsWidget::SettingsWidget(QWidget *parent) : QWidget(parent)
 	auto launchLayout = new QHBoxLayout();
 	launchButton = new QPushButton("Launch Apps", this);
 	quitButton = new QPushButton("Quit Apps", this);
+	switchButton = new QPushButton("Switch to", this);
+	switchButton->setToolTip(
+		"Quit the programs that are not part of this loadout and launch the missing ones");
 	launchLayout->addWidget(launchButton);
+	launchLayout->addWidget(switchButton);
 	launchLayout->addWidget(quitButton);
 	mainLayout->addLayout(launchLayout);
 
@@ -138,21 +293,39 @@ SettingsWidget::SettingsWidget(QWidget *parent) : QWidget(parent)
 		&SettingsWidget::onLaunchApps);
 	connect(quitButton, &QPushButton::clicked, this,
 		&SettingsWidget::onQuitApps);
+	connect(switchButton, &QPushButton::clicked, this,
+		&SettingsWidget::onSwitchApps);
 
 	// Load initial values from config
-	enableCheckbox->setChecked(config.enabled);
-	askToLaunchCheckbox->setChecked(config.askToLaunch);
-	autocloseCheckbox->setChecked(config.autoclose);
-
-	if (!config.loadouts.empty()) {
-		if (config.currentLoadout.empty()) {
-			config.currentLoadout = config.loadouts[0].name;
+	enableCheckbox->setChecked(draft.enabled);
+	askToLaunchCheckbox->setChecked(draft.askToLaunch);
+	autocloseCheckbox->setChecked(draft.autoclose);
+	quitRecoveredCheckbox->setChecked(draft.quitRecoveredPrograms);
+
+	if (!draft.loadouts.empty()) {
+		if (draft.currentLoadout.empty()) {
+			draft.currentLoadout = draft.loadouts[0].name;
 		}
 		loadoutCombo->setCurrentText(
-			QString::fromStdString(config.currentLoadout));
+			QString::fromStdString(draft.currentLoadout));
 		UpdateProgramList();
 	}
 
+	// Refresh live usage while the window is open
+	usageTimer = new QTimer(this);
+	connect(usageTimer, &QTimer::timeout, this,
+		&SettingsWidget::UpdateUsage);
+	usageTimer->start(Constants::SAMPLE_INTERVAL_MS);
+
+	// Process starts and exits are pushed in batches, no polling
+	connect(&ProcessEvents::Get(), &ProcessEvents::statusChanged, this,
+		&SettingsWidget::onProcessStatusChanged);
+
+	// Re-check all programs without blocking the window
+	connect(&Preflight::Get(), &Preflight::finished, this,
+		&SettingsWidget::UpdatePreflight);
+	Preflight::Get().Start();
+
 	resize(Constants::DEFAULT_WINDOW_WIDTH,
 	       Constants::DEFAULT_WINDOW_HEIGHT);
 }
@@ -179,29 +352,26 @@ void SettingsWidget::ShowSettings()
 
 void SettingsWidget::onSave()
 {
-	auto &config = PluginConfig::Get();
-	config.enabled = enableCheckbox->isChecked();
-	config.askToLaunch = askToLaunchCheckbox->isChecked();
-	config.autoclose = autocloseCheckbox->isChecked();
-	config.currentLoadout = loadoutCombo->currentText().toStdString();
+	draft.enabled = enableCheckbox->isChecked();
+	draft.askToLaunch = askToLaunchCheckbox->isChecked();
+	draft.autoclose = autocloseCheckbox->isChecked();
+	draft.quitRecoveredPrograms = quitRecoveredCheckbox->isChecked();
+	draft.currentLoadout = loadoutCombo->currentText().toStdString();
 
-	if (Loadout *loadout = config.GetLoadout(
+	if (Loadout *loadout = draft.GetLoadout(
 		    loadoutCombo->currentText().toStdString())) {
 		for (int i = 0; i < programsList->count(); i++) {
 			auto item = programsList->item(i);
 			auto widget = qobject_cast<ProgramListItem *>(
 				programsList->itemWidget(item));
 			if (widget) {
-				QFileInfo fileInfo(widget->getPath());
 				for (auto &program : loadout->programs) {
-					if (program.path ==
-						    fileInfo.absolutePath()
-							    .toStdString() &&
-					    program.executable ==
-						    fileInfo.fileName()
-							    .toStdString()) {
+					if (ProgramDisplayPath(program) ==
+					    widget->getPath()) {
 						program.minimized =
 							widget->isMinimized();
+						program.captureOutput =
+							widget->isCapturingOutput();
 						break;
 					}
 				}
@@ -209,7 +379,10 @@ void SettingsWidget::onSave()
 		}
 	}
 
-	config.Save();
+	// Publish the edited copy so running launches keep their snapshot
+	PluginConfig::Get().Commit(draft);
+	Supervisor::SetAutoclose(draft.autoclose);
+	Preflight::Get().Start();
 	close();
 }
 
@@ -232,8 +405,7 @@ void SettingsWidget::onAddProgram()
         return;
     }
 
-    auto &config = PluginConfig::Get();
-    if (Loadout *loadout = config.GetLoadout(loadoutCombo->currentText().toStdString())) {
+    if (Loadout *loadout = draft.GetLoadout(loadoutCombo->currentText().toStdString())) {
         Program program;
         program.path = fileInfo.absolutePath().toStdString();
         program.executable = fileInfo.fileName().toStdString();
@@ -241,7 +413,9 @@ void SettingsWidget::onAddProgram()
         loadout->programs.push_back(program);
 
         auto item = new QListWidgetItem(programsList);
-        auto widget = new ProgramListItem(filename, false, programsList);
+        QString logPath = QString::fromStdString(OutputCapture::LogPath(
+            loadout->name, ResolveProgramPath(program)));
+        auto widget = new ProgramListItem(filename, false, false, logPath, programsList);
         item->setSizeHint(QSize(item->sizeHint().width(), 30)); // Set consistent height
         programsList->setItemWidget(item, widget);
     } else {
@@ -262,16 +436,14 @@ void SettingsWidget::onDeleteProgram()
         return;
     }
 
-    QFileInfo fileInfo(widget->getPath());
-    auto &config = PluginConfig::Get();
-    if (Loadout *loadout = config.GetLoadout(loadoutCombo->currentText().toStdString())) {
+    QString path = widget->getPath();
+    if (Loadout *loadout = draft.GetLoadout(loadoutCombo->currentText().toStdString())) {
         auto &programs = loadout->programs;
         programs.erase(
             std::remove_if(
                 programs.begin(), programs.end(),
-                [&fileInfo](const Program &p) {
-                    return (p.path == fileInfo.absolutePath().toStdString() &&
-                           p.executable == fileInfo.fileName().toStdString());
+                [&path](const Program &p) {
+                    return ProgramDisplayPath(p) == path;
                 }),
             programs.end());
     }
@@ -280,31 +452,228 @@ void SettingsWidget::onDeleteProgram()
 
 void SettingsWidget::onLaunchApps()
 {
-	// Trigger launching apps in the selected loadout
-	AutoStarter::LaunchPrograms(loadoutCombo->currentText().toStdString());
+	// Trigger launching apps in the selected loadout without blocking the UI
+	LaunchJob *job = AutoStarter::LaunchProgramsAsync(
+		loadoutCombo->currentText().toStdString());
+	if (!job)
+		return;
+
+	launchButton->setEnabled(false);
+	connect(job, &LaunchJob::finished, this, [this]() {
+		launchButton->setEnabled(true);
+		UpdateLoadoutState();
+	});
+	output_triggers_track_launch(job);
+	LaunchProgressWidget::ShowProgress(job);
+}
+
+void SettingsWidget::onSwitchApps()
+{
+	LaunchJob *job = AutoStarter::SwitchLoadout(
+		loadoutCombo->currentText().toStdString());
+	if (!job)
+		return;
+
+	switchButton->setEnabled(false);
+	connect(job, &LaunchJob::finished, this, [this]() {
+		switchButton->setEnabled(true);
+		UpdateLoadoutState();
+	});
+	output_triggers_track_launch(job);
+	LaunchProgressWidget::ShowProgress(job);
 }
 
 void SettingsWidget::onQuitApps()
 {
 	// Trigger quitting launched apps
 	AutoStarter::QuitPrograms();
+	UpdateLoadoutState();
 }
 
 void SettingsWidget::UpdateProgramList()
 {
 	programsList->clear();
-	auto &config = PluginConfig::Get();
-	if (Loadout *loadout = config.GetLoadout(
+	if (Loadout *loadout = draft.GetLoadout(
 		    loadoutCombo->currentText().toStdString())) {
+		// Show the loadout's options without writing them back
+		QSignalBlocker triggerBlocker(triggerCombo);
+		QSignalBlocker freezeBlocker(freezeCheckbox);
+		triggerCombo->setCurrentIndex(
+			triggerCombo->findData((int)loadout->trigger));
+		freezeCheckbox->setChecked(loadout->freezeWhenIdle);
+		QStringList includes;
+		for (const auto &include : loadout->includes)
+			includes.append(QString::fromStdString(include));
+		includesEdit->setText(includes.join(", "));
+
 		for (const auto &program : loadout->programs) {
-			QString fullPath = QString::fromStdString(
-				program.path + "/" + program.executable);
+			QString fullPath = ProgramDisplayPath(program);
 			auto item = new QListWidgetItem(programsList);
+			QString logPath = QString::fromStdString(
+				OutputCapture::LogPath(
+					loadout->name,
+					ResolveProgramPath(program)));
 			auto widget = new ProgramListItem(
-				fullPath, program.minimized, programsList);
+				fullPath, program.minimized,
+				program.captureOutput, logPath, programsList);
 			item->setSizeHint(QSize(item->sizeHint().width(),
 						30)); // Set consistent height
 			programsList->setItemWidget(item, widget);
+
+			ProcessStatus status;
+			if (ProcessEvents::Get().Lookup(
+				    loadout->name, ResolveProgramPath(program),
+				    status))
+				widget->setStatus(&status);
+		}
+	}
+
+	UpdatePreflight();
+	UpdateLoadoutState();
+}
+
+void SettingsWidget::onProcessStatusChanged(
+	const std::vector<ProcessStatus> &changes)
+{
+	const Loadout *loadout =
+		draft.GetLoadout(loadoutCombo->currentText().toStdString());
+	if (!loadout)
+		return;
+
+	// Plans also hold included programs, so rows are matched by path
+	for (int i = 0; i < programsList->count() &&
+			(size_t)i < loadout->programs.size();
+	     i++) {
+		std::wstring path = ResolveProgramPath(loadout->programs[i]);
+		for (const auto &status : changes) {
+			if (status.loadout != loadout->name ||
+			    _wcsicmp(status.path.c_str(), path.c_str()) != 0)
+				continue;
+
+			auto widget = qobject_cast<ProgramListItem *>(
+				programsList->itemWidget(programsList->item(i)));
+			if (widget)
+				widget->setStatus(&status);
+		}
+	}
+}
+
+void SettingsWidget::UpdatePreflight()
+{
+	const Loadout *loadout =
+		draft.GetLoadout(loadoutCombo->currentText().toStdString());
+	if (!loadout)
+		return;
+
+	// Rows mirror the programs of the draft loadout
+	for (int i = 0; i < programsList->count(); i++) {
+		auto widget = qobject_cast<ProgramListItem *>(
+			programsList->itemWidget(programsList->item(i)));
+		if (!widget || (size_t)i >= loadout->programs.size())
+			continue;
+
+		PreflightResult result;
+		if (Preflight::Get().Lookup(
+			    ResolveProgramPath(loadout->programs[i]), result) &&
+		    !result.ok) {
+			widget->setProblem(
+				QString::fromStdString(result.reason));
+		} else {
+			widget->setProblem(QString());
+		}
+	}
+}
+
+void SettingsWidget::onTriggerChanged(int index)
+{
+	if (Loadout *loadout = draft.GetLoadout(
+		    loadoutCombo->currentText().toStdString())) {
+		loadout->trigger =
+			(LaunchTrigger)triggerCombo->itemData(index).toInt();
+	}
+}
+
+void SettingsWidget::onFreezeToggled(bool checked)
+{
+	if (Loadout *loadout = draft.GetLoadout(
+		    loadoutCombo->currentText().toStdString())) {
+		loadout->freezeWhenIdle = checked;
+	}
+}
+
+void SettingsWidget::onIncludesEdited()
+{
+	Loadout *loadout =
+		draft.GetLoadout(loadoutCombo->currentText().toStdString());
+	if (!loadout)
+		return;
+
+	std::vector<std::string> includes;
+	for (const auto &name :
+	     includesEdit->text().split(',', Qt::SkipEmptyParts)) {
+		std::string include = name.trimmed().toStdString();
+		if (include.empty())
+			continue;
+		if (!draft.GetLoadout(include)) {
+			QMessageBox::warning(this, "Error",
+					     QString("Loadout '%1' does not exist")
+						     .arg(name.trimmed()));
+			UpdateProgramList();
+			return;
+		}
+		includes.push_back(include);
+	}
+
+	std::vector<std::string> previous = loadout->includes;
+	loadout->includes = includes;
+	if (draft.HasIncludeCycle(loadout->name)) {
+		loadout->includes = previous;
+		QMessageBox::warning(this, "Error",
+				     "Loadouts cannot include each other");
+		UpdateProgramList();
+	}
+}
+
+void SettingsWidget::RefreshLoadoutState()
+{
+	if (settings_instance)
+		settings_instance->UpdateLoadoutState();
+}
+
+void SettingsWidget::UpdateLoadoutState()
+{
+	std::string name = loadoutCombo->currentText().toStdString();
+	if (AutoStarter::IsLoadoutFrozen(name)) {
+		stateLabel->setText("State: Frozen");
+	} else if (AutoStarter::IsLoadoutLaunched(name)) {
+		stateLabel->setText("State: Running");
+	} else {
+		stateLabel->setText("State: Not running");
+	}
+}
+
+void SettingsWidget::UpdateUsage()
+{
+	const Loadout *loadout =
+		draft.GetLoadout(loadoutCombo->currentText().toStdString());
+	if (!loadout)
+		return;
+
+	for (int i = 0; i < programsList->count(); i++) {
+		auto widget = qobject_cast<ProgramListItem *>(
+			programsList->itemWidget(programsList->item(i)));
+		if (!widget || (size_t)i >= loadout->programs.size())
+			continue;
+
+		widget->refreshUptime();
+		ResourceHistory history;
+		if (ResourceSampler::GetHistory(
+			    loadout->name,
+			    ResolveProgramPath(loadout->programs[i]),
+			    history)) {
+			widget->setUsage(&history.Latest());
+		} else {
+			widget->setUsage(nullptr);
 		}
 	}
 }
@@ -343,8 +712,7 @@ void SettingsWidget::onAddLoadoutClicked()
 			return;
 		}
 
-		auto &config = PluginConfig::Get();
-		if (config.AddLoadout(nameField->text().toStdString())) {
+		if (draft.AddLoadout(nameField->text().toStdString())) {
 			loadoutCombo->addItem(nameField->text());
 			loadoutCombo->setCurrentText(nameField->text());
 			dialog.accept();
@@ -373,14 +741,13 @@ void SettingsWidget::onRemoveLoadoutClicked()
 	confirm.setDefaultButton(QMessageBox::Cancel);
 
 	if (confirm.exec() == QMessageBox::Yes) {
-		auto &config = PluginConfig::Get();
-		config.RemoveLoadout(currentLoadout.toStdString());
+		draft.RemoveLoadout(currentLoadout.toStdString());
 		loadoutCombo->removeItem(loadoutCombo->currentIndex());
 		// If no loadouts left, create a default one
-		if (config.loadouts.empty()) {
-			config.InitDefaultLoadout();
+		if (draft.loadouts.empty()) {
+			draft.InitDefaultLoadout();
 			loadoutCombo->addItem(QString::fromStdString(
-				config.loadouts[0].name));
+				draft.loadouts[0].name));
 		}
 	}
 }
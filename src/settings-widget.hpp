@@ -7,6 +7,12 @@
 #include <QLineEdit>
 #include <QLabel>
 #include <QHBoxLayout>
+#include <QTimer>
+#include "config.hpp"
+#include <vector>
+
+struct ResourceSample;
+struct ProcessStatus;
 
 class ProgramListItem : public QWidget {
 	Q_OBJECT
@@ -15,14 +21,45 @@ public:
 	 * @brief Constructs a single program item widget.
 	 * @param path Full path (directory + filename).
 	 * @param minimized Whether program should launch minimized.
+	 * @param captureOutput Whether program output is written to a log file.
+	 * @param logPath Path of the program's output log.
 	 * @param parent Parent widget pointer.
 	 */
-	ProgramListItem(const QString &path, bool minimized, QWidget *parent = nullptr);
+	ProgramListItem(const QString &path, bool minimized, bool captureOutput,
+			const QString &logPath, QWidget *parent = nullptr);
 	QString getPath() const { return fullPath; }
 	bool isMinimized() const { return minimizedBox->isChecked(); }
+	bool isCapturingOutput() const { return captureBox->isChecked(); }
+	/**
+	 * @brief Shows the latest resource usage, or clears it if sample is nullptr.
+	 */
+	void setUsage(const ResourceSample *sample);
+	/**
+	 * @brief Marks the program as unlaunchable, or clears the mark if reason is empty.
+	 */
+	void setProblem(const QString &reason);
+	/**
+	 * @brief Shows whether the program runs, its PID and uptime, or clears it if status is nullptr.
+	 */
+	void setStatus(const ProcessStatus *status);
+	/**
+	 * @brief Advances the shown uptime of a running program.
+	 */
+	void refreshUptime();
 
 private:
 	QString fullPath;
+	/**
+	 * @brief Label that displays the running state, PID and uptime.
+	 */
+	QLabel *statusLabel;
+	bool running = false;
+	unsigned long processId = 0;
+	uint64_t startTime = 0;
+	/**
+	 * @brief Label that displays live CPU and memory usage.
+	 */
+	QLabel *usageLabel;
 	/**
 	 * @brief Label that displays the program's name or filename.
 	 */
@@ -31,6 +68,14 @@ private:
 	 * @brief Checkbox indicating if the program should be launched minimized.
 	 */
 	QCheckBox *minimizedBox;
+	/**
+	 * @brief Checkbox indicating if the program's output should be logged.
+	 */
+	QCheckBox *captureBox;
+	/**
+	 * @brief Button that opens the program's output log.
+	 */
+	QPushButton *logButton;
 };
 
 /**
@@ -52,6 +97,10 @@ public:
 	 * @brief Shows settings as a singleton widget.
 	 */
 	static void ShowSettings();
+	/**
+	 * @brief Refreshes the launch state label of the open settings window, if any.
+	 */
+	static void RefreshLoadoutState();
 
 private:
 	QLabel *titleLabel;
@@ -62,11 +111,13 @@ private:
 	QPushButton *deleteProgramButton;
 	QCheckBox *askToLaunchCheckbox;
 	QCheckBox *autocloseCheckbox;
+	QCheckBox *quitRecoveredCheckbox;
 	QPushButton *saveButton;
 	QPushButton *closeButton;
 	QPushButton *launchButton;
 	QLabel *versionLabel;
 	QPushButton *quitButton;
+	QPushButton *switchButton;
 	QLabel *socialLabel;
 	QLabel *githubLink;
 	QLabel *discordLink;
@@ -74,11 +125,36 @@ private:
 	QHBoxLayout *loadoutLayout;
 	QPushButton *addLoadoutButton;
 	QPushButton *removeLoadoutButton;
+	QComboBox *triggerCombo;
+	QCheckBox *freezeCheckbox;
+	QLineEdit *includesEdit;
+	QLabel *stateLabel;
+	QTimer *usageTimer;
+	/**
+	 * @brief Private copy of the configuration, committed on save.
+	 */
+	ConfigData draft;
 
 	/**
 	 * @brief Updates the program list according to the selected loadout.
 	 */
 	void UpdateProgramList();
+	/**
+	 * @brief Shows whether the selected loadout is running, frozen or stopped.
+	 */
+	void UpdateLoadoutState();
+	/**
+	 * @brief Shows the latest sampled resource usage on each program row.
+	 */
+	void UpdateUsage();
+	/**
+	 * @brief Flags program rows that failed the preflight check.
+	 */
+	void UpdatePreflight();
+	/**
+	 * @brief Updates the status of the rows whose processes started or exited.
+	 */
+	void onProcessStatusChanged(const std::vector<ProcessStatus> &changes);
 
 private slots:
 	/**
@@ -96,8 +172,24 @@ private slots:
 	void onDeleteProgram();
 	void onLaunchApps();
 	void onQuitApps();
+	/**
+	 * @brief Switch to the selected loadout, restarting only programs that differ.
+	 */
+	void onSwitchApps();
 	void onAddLoadoutClicked();
 	void onRemoveLoadoutClicked();
+	/**
+	 * @brief Store the selected launch trigger in the current loadout.
+	 */
+	void onTriggerChanged(int index);
+	/**
+	 * @brief Store the freeze-when-idle option in the current loadout.
+	 */
+	void onFreezeToggled(bool checked);
+	/**
+	 * @brief Store the included loadouts of the current loadout, rejecting missing names and cycles.
+	 */
+	void onIncludesEdited();
 };
 
 extern SettingsWidget *settings_instance;
@@ -0,0 +1,99 @@
+// Adjusts spawn concurrency to CPU and memory pressure
+#include <windows.h>
+#include "spawn-throttle.hpp"
+#include "host.hpp"
+#include <algorithm>
+
+namespace {
+
+uint64_t ToUInt64(const FILETIME &time)
+{
+	return ((uint64_t)time.dwHighDateTime << 32) | time.dwLowDateTime;
+}
+
+} // namespace
+
+SpawnThrottle::SpawnThrottle(int maxParallel, double cpuHigh, double memoryHigh)
+	: maxParallel(std::max(1, maxParallel)),
+	  cpuHigh(cpuHigh),
+	  memoryHigh(memoryHigh)
+{
+	// Take the first CPU reading so the next update has a baseline
+	FILETIME idle, kernel, user;
+	if (GetSystemTimes(&idle, &kernel, &user)) {
+		lastIdleTime = ToUInt64(idle);
+		lastTotalTime = ToUInt64(kernel) + ToUInt64(user);
+	}
+	lastSampleMs = GetTickCount64();
+	lastFrames = FrameStats::Sample();
+}
+
+int SpawnThrottle::Update()
+{
+	uint64_t now = GetTickCount64();
+	int previous = limit;
+
+	// Frame counters are cheap to read, so they are checked on every call
+	// and a spawn never starts right after frames were lost
+	FrameStats frames = FrameStats::Sample();
+	bool framesLost = frames.LostSince(lastFrames);
+	lastFrames = frames;
+	if (framesLost) {
+		if (pausedSinceMs == 0)
+			pausedSinceMs = now;
+		// Never stall a launch for good, continue one at a time instead
+		limit = now - pausedSinceMs < MaxPauseMs ? 0 : 1;
+		// Resuming needs a full interval without lost frames
+		lastSampleMs = now;
+		if (limit != previous) {
+			Host::Log(Host::Info,
+				  "Spawn limit %d -> %d (lagged %u, skipped %u, dropped %lld frames)",
+				  previous, limit, frames.laggedFrames,
+				  frames.skippedFrames,
+				  (long long)frames.droppedFrames);
+		}
+		return limit;
+	}
+
+	// Shorter intervals give too noisy a CPU reading
+	if (now - lastSampleMs < SampleIntervalMs)
+		return limit;
+	lastSampleMs = now;
+
+	FILETIME idle, kernel, user;
+	if (!GetSystemTimes(&idle, &kernel, &user))
+		return limit;
+
+	// Kernel time includes idle time
+	uint64_t idleTime = ToUInt64(idle);
+	uint64_t totalTime = ToUInt64(kernel) + ToUInt64(user);
+	uint64_t idleDelta = idleTime - lastIdleTime;
+	uint64_t totalDelta = totalTime - lastTotalTime;
+	if (totalDelta == 0)
+		return limit;
+	lastIdleTime = idleTime;
+	lastTotalTime = totalTime;
+
+	double cpuBusy = 100.0 * (double)(totalDelta - idleDelta) /
+			 (double)totalDelta;
+
+	MEMORYSTATUSEX memory = {sizeof(memory)};
+	double memoryLoad = GlobalMemoryStatusEx(&memory)
+				    ? (double)memory.dwMemoryLoad
+				    : 0.0;
+
+	pausedSinceMs = 0;
+	if (limit == 0)
+		limit = 1;
+	else if (cpuBusy > cpuHigh || memoryLoad > memoryHigh)
+		limit = std::max(1, limit / 2);
+	else if (cpuBusy < cpuHigh / 2.0)
+		limit = std::min(maxParallel, limit + 1);
+
+	if (limit != previous) {
+		Host::Log(Host::Info,
+			  "Spawn limit %d -> %d (CPU %.0f%%, memory %.0f%%)",
+			  previous, limit, cpuBusy, memoryLoad);
+	}
+	return limit;
+}
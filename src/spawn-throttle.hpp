@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include "frame-stats.hpp"
+
+/**
+ * @brief Adapts how many programs may be spawned at once to system load.
+ *
+ * The limit grows by one while the machine is idle and is halved as soon
+ * as CPU or memory pressure crosses its threshold, so a loadout launches
+ * quickly on an idle machine without causing a spawn storm on a busy one.
+ *
+ * Spawning pauses while OBS lags, skips or drops frames and resumes once
+ * the frame counters settle. The frame counters are read on every update,
+ * system pressure at most every SampleIntervalMs. If frames are still lost after MaxPauseMs,
+ * programs continue to launch one at a time.
+ */
+class SpawnThrottle {
+public:
+	/**
+	 * @brief Creates a throttle that starts with a single spawn at a time.
+	 * @param maxParallel Upper bound for concurrent spawns.
+	 * @param cpuHigh CPU usage in percent above which spawning backs off.
+	 * @param memoryHigh Memory load in percent above which spawning backs off.
+	 */
+	SpawnThrottle(int maxParallel, double cpuHigh, double memoryHigh);
+
+	/**
+	 * @brief Samples system pressure and frame health and adjusts the limit.
+	 * @return The new number of spawns allowed at once, 0 while paused.
+	 */
+	int Update();
+
+	/**
+	 * @brief Returns the current number of spawns allowed at once, 0 while paused.
+	 */
+	int Limit() const { return limit; }
+
+private:
+	static constexpr uint64_t SampleIntervalMs = 100;
+	static constexpr uint64_t MaxPauseMs = 5000;
+
+	int maxParallel;
+	double cpuHigh;
+	double memoryHigh;
+	int limit = 1;
+	uint64_t lastIdleTime = 0;
+	uint64_t lastTotalTime = 0;
+	uint64_t lastSampleMs = 0;
+	FrameStats lastFrames;
+	uint64_t pausedSinceMs = 0; ///< When frames started to get lost, 0 if they are not
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * @brief Layout of the status page shared with external monitors.
+ *
+ * One OBS instance per session publishes the programs it tracks into a
+ * named shared-memory section. When it exits, another running instance
+ * takes over and replaces the programs with its own. The page is protected by a sequence lock:
+ * the publisher makes `sequence` odd before it changes the page and even
+ * again afterwards. Readers copy the whole page and keep the copy only if
+ * `sequence` was even and unchanged around the copy, so they never block
+ * the publisher and need no system calls once the section is mapped. See
+ * status-reader-main.cpp for a reference reader.
+ */
+namespace StatusPageLayout {
+
+/// Name of the shared-memory section, local to the logon session
+inline constexpr wchar_t MappingName[] = L"Local\\AutostarterStatus";
+
+inline constexpr uint32_t Magic = 0x50535341; ///< "ASSP"
+inline constexpr uint32_t Version = 1;
+inline constexpr uint32_t MaxPrograms = 64;
+inline constexpr uint32_t NameLength = 64; ///< Including the terminator
+
+enum ProgramFlags : uint32_t {
+	Running = 1 << 0, ///< Process is tracked and has not exited
+	Frozen = 1 << 1   ///< Process is suspended
+};
+
+/**
+ * @brief One program, kept after it exits so readers see its history.
+ */
+struct Program {
+	char loadout[NameLength]; ///< UTF-8, truncated
+	char name[NameLength];    ///< UTF-8 display name, truncated
+	uint32_t processId;       ///< Last known process ID
+	uint32_t flags;           ///< ProgramFlags
+	uint32_t launches;        ///< Launches by the publisher, restarts are launches - 1
+	uint32_t reserved;
+	uint64_t launchTime;      ///< FILETIME of the last launch, 0 if only adopted
+	uint64_t launchLatencyUs; ///< Duration of the last launch call
+};
+
+struct Page {
+	uint32_t magic;
+	uint32_t version;
+	volatile int64_t sequence;     ///< Odd while the publisher writes
+	volatile uint32_t publisherId; ///< Process ID of the publishing OBS instance, 0 if none
+	uint32_t programCount;
+	uint64_t updateTime;           ///< FILETIME of the last change
+	Program programs[MaxPrograms];
+};
+
+} // namespace StatusPageLayout
@@ -0,0 +1,325 @@
+// Publishes the tracked programs into shared memory under a sequence lock
+#include <windows.h>
+#include "status-page.hpp"
+#include "status-page-layout.hpp"
+#include "host.hpp"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+using namespace StatusPageLayout;
+
+namespace {
+
+std::mutex pageMutex; ///< Serializes writers, the seqlock allows only one
+HANDLE mapping = nullptr;
+Page *page = nullptr; ///< Mapped only while this instance publishes
+bool full = false;    ///< Whether running out of slots was already logged
+
+/// Programs of this instance, copied to the page once it publishes
+Page local = {};
+bool wanted = false; ///< Between Open() and Close()
+HANDLE publisherProcess = nullptr; ///< Live publisher this instance waits for
+HANDLE publisherWait = nullptr;
+
+uint64_t FileTimeNow()
+{
+	FILETIME now;
+	GetSystemTimeAsFileTime(&now);
+	return ((uint64_t)now.dwHighDateTime << 32) | now.dwLowDateTime;
+}
+
+void Unmap()
+{
+	if (page)
+		UnmapViewOfFile(page);
+	if (mapping)
+		CloseHandle(mapping);
+	page = nullptr;
+	mapping = nullptr;
+}
+
+/**
+ * @brief Makes the sequence odd, readers discard copies from now on.
+ * Requires pageMutex.
+ */
+void BeginWrite()
+{
+	// Interlocked operations are full barriers on both ends
+	InterlockedIncrement64((volatile LONG64 *)&page->sequence);
+}
+
+/**
+ * @brief Makes the sequence even again once the page is consistent.
+ * Requires pageMutex.
+ */
+void EndWrite()
+{
+	page->updateTime = FileTimeNow();
+	InterlockedIncrement64((volatile LONG64 *)&page->sequence);
+}
+
+void CopyName(char (&target)[NameLength], const std::string &source)
+{
+	size_t length = std::min<size_t>(source.size(), NameLength - 1);
+	// Do not cut a UTF-8 sequence in half
+	while (length > 0 && length < source.size() &&
+	       ((unsigned char)source[length] & 0xC0) == 0x80)
+		length--;
+	memcpy(target, source.data(), length);
+	memset(target + length, 0, NameLength - length);
+}
+
+/**
+ * @brief Finds the slot of a program in the local copy, claiming a new one
+ * if needed. Requires pageMutex.
+ * @return nullptr if the page is full.
+ */
+Program *FindOrAdd(const std::string &loadout, const std::string &program)
+{
+	Program candidate = {};
+	CopyName(candidate.loadout, loadout);
+	CopyName(candidate.name, program);
+	for (uint32_t i = 0; i < local.programCount; i++) {
+		Program &slot = local.programs[i];
+		if (strcmp(slot.loadout, candidate.loadout) == 0 &&
+		    strcmp(slot.name, candidate.name) == 0)
+			return &slot;
+	}
+
+	if (local.programCount == MaxPrograms) {
+		if (!full)
+			Host::Log(Host::Warning,
+				  "Status page is full, '%s' is not published",
+				  program.c_str());
+		full = true;
+		return nullptr;
+	}
+
+	Program &slot = local.programs[local.programCount++];
+	slot = candidate;
+	return &slot;
+}
+
+/**
+ * @brief Finds the running slot of a process in the local copy. Requires
+ * pageMutex.
+ */
+Program *FindRunning(unsigned long processId)
+{
+	for (uint32_t i = 0; i < local.programCount; i++) {
+		Program &slot = local.programs[i];
+		if (slot.processId == processId && (slot.flags & Running))
+			return &slot;
+	}
+	return nullptr;
+}
+
+/**
+ * @brief Copies the local programs to the page if this instance publishes.
+ * Requires pageMutex.
+ */
+void Publish()
+{
+	if (!page)
+		return;
+
+	BeginWrite();
+	page->programCount = local.programCount;
+	memcpy(page->programs, local.programs,
+	       local.programCount * sizeof(Program));
+	EndWrite();
+}
+
+/**
+ * @brief Drops the wait for the exit of another publisher. Requires
+ * pageMutex.
+ * @param completion Passed on to UnregisterWaitEx().
+ */
+void StopWatchingPublisher(HANDLE completion)
+{
+	if (publisherWait)
+		UnregisterWaitEx(publisherWait, completion);
+	if (publisherProcess)
+		CloseHandle(publisherProcess);
+	publisherWait = nullptr;
+	publisherProcess = nullptr;
+}
+
+bool TryPublish();
+
+VOID CALLBACK OnPublisherExited(PVOID, BOOLEAN)
+{
+	std::lock_guard<std::mutex> lock(pageMutex);
+	if (!wanted || !publisherWait)
+		return;
+
+	// Cannot block on its own wait, the callback is returning anyway
+	StopWatchingPublisher(nullptr);
+	if (TryPublish())
+		Host::Log(Host::Info,
+			  "Took over publishing the status from the exited OBS instance");
+}
+
+/**
+ * @brief Maps the page and becomes its publisher. While another instance
+ * publishes, waits for its exit to try again. Requires pageMutex.
+ */
+bool TryPublish()
+{
+	mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr,
+				     PAGE_READWRITE, 0, sizeof(Page),
+				     MappingName);
+	if (!mapping) {
+		Host::Log(Host::Warning,
+			  "Failed to create status page, error code: %lu",
+			  GetLastError());
+		return false;
+	}
+	bool created = GetLastError() != ERROR_ALREADY_EXISTS;
+
+	page = (Page *)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0,
+				     sizeof(Page));
+	if (!page) {
+		Unmap();
+		return false;
+	}
+
+	// New mappings are zero-filled, readers wait for the magic
+	if (created) {
+		page->version = Version;
+		InterlockedExchange((volatile LONG *)&page->magic, Magic);
+	} else if (page->magic != Magic || page->version != Version) {
+		Host::Log(Host::Warning,
+			  "Status page version mismatch, status not published");
+		Unmap();
+		return false;
+	}
+
+	// Take over from a publisher that crashed, never from a live one
+	LONG self = (LONG)GetCurrentProcessId();
+	for (;;) {
+		LONG publisher = InterlockedCompareExchange(
+			(volatile LONG *)&page->publisherId, self, 0);
+		if (publisher == 0)
+			break;
+
+		HANDLE process =
+			OpenProcess(SYNCHRONIZE, FALSE, (DWORD)publisher);
+		if (process && WaitForSingleObject(process, 0) == WAIT_TIMEOUT) {
+			Unmap();
+			publisherProcess = process;
+			if (!RegisterWaitForSingleObject(
+				    &publisherWait, process, OnPublisherExited,
+				    nullptr, INFINITE, WT_EXECUTEONLYONCE)) {
+				publisherWait = nullptr;
+				StopWatchingPublisher(nullptr);
+			}
+			Host::Log(Host::Info,
+				  "Status is published by another OBS instance (PID %ld)",
+				  publisher);
+			return false;
+		}
+		if (process)
+			CloseHandle(process);
+		InterlockedCompareExchange((volatile LONG *)&page->publisherId,
+					   0, publisher);
+	}
+
+	// A crash in the middle of a write leaves the sequence odd
+	if (page->sequence & 1)
+		InterlockedIncrement64((volatile LONG64 *)&page->sequence);
+	Publish();
+	return true;
+}
+
+} // namespace
+
+bool StatusPage::Open()
+{
+	std::lock_guard<std::mutex> lock(pageMutex);
+	if (page)
+		return true;
+	if (publisherWait)
+		return false;
+
+	wanted = true;
+	return TryPublish();
+}
+
+void StatusPage::Close()
+{
+	HANDLE wait = nullptr;
+	HANDLE process = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(pageMutex);
+		wanted = false;
+		local.programCount = 0;
+		full = false;
+		// The callback takes the lock, so the wait is removed after it
+		std::swap(wait, publisherWait);
+		std::swap(process, publisherProcess);
+
+		if (page) {
+			BeginWrite();
+			page->programCount = 0;
+			EndWrite();
+			InterlockedExchange((volatile LONG *)&page->publisherId,
+					    0);
+			Unmap();
+		}
+	}
+
+	// Blocks until a running callback has returned
+	if (wait)
+		UnregisterWaitEx(wait, INVALID_HANDLE_VALUE);
+	if (process)
+		CloseHandle(process);
+}
+
+void StatusPage::Launched(const std::string &loadout,
+			  const std::string &program, unsigned long processId,
+			  uint64_t latencyNs)
+{
+	std::lock_guard<std::mutex> lock(pageMutex);
+	if (Program *slot = FindOrAdd(loadout, program)) {
+		slot->processId = processId;
+		slot->flags = Running;
+		slot->launches++;
+		slot->launchTime = FileTimeNow();
+		slot->launchLatencyUs = latencyNs / 1000;
+	}
+	Publish();
+}
+
+void StatusPage::Tracked(const std::string &loadout,
+			 const std::string &program, unsigned long processId)
+{
+	std::lock_guard<std::mutex> lock(pageMutex);
+	// A program tracked under another loadout moves with it
+	if (Program *previous = FindRunning(processId))
+		previous->flags = 0;
+	if (Program *slot = FindOrAdd(loadout, program)) {
+		slot->processId = processId;
+		slot->flags = Running;
+	}
+	Publish();
+}
+
+void StatusPage::Stopped(unsigned long processId)
+{
+	std::lock_guard<std::mutex> lock(pageMutex);
+	if (Program *slot = FindRunning(processId)) {
+		slot->flags = 0;
+		Publish();
+	}
+}
+
+void StatusPage::SetFrozen(unsigned long processId, bool frozen)
+{
+	std::lock_guard<std::mutex> lock(pageMutex);
+	if (Program *slot = FindRunning(processId)) {
+		slot->flags = frozen ? (Running | Frozen) : Running;
+		Publish();
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Publishes the tracked programs for external monitors.
+ *
+ * Dashboards and Stream Deck plugins read the page at high frequency
+ * without asking OBS, see status-page-layout.hpp for the layout and the
+ * read protocol. Only one instance of a session publishes at a time. The
+ * others keep their programs locally, and the first to notice the exit of
+ * the publisher takes over with its own programs.
+ */
+class StatusPage {
+public:
+	/**
+	 * @brief Maps the page and becomes its publisher, or waits for the
+	 * current publisher to exit.
+	 * @return true if this instance publishes right away.
+	 */
+	static bool Open();
+
+	/**
+	 * @brief Empties the page, gives up publishing and unmaps it, or stops
+	 * waiting for the current publisher.
+	 */
+	static void Close();
+
+	/**
+	 * @brief Records a program this instance spawned.
+	 * @param loadout Loadout the program was launched from.
+	 * @param program Display name of the program.
+	 * @param processId ID of the new process.
+	 * @param latencyNs Duration of the launch call.
+	 */
+	static void Launched(const std::string &loadout,
+			     const std::string &program,
+			     unsigned long processId, uint64_t latencyNs);
+
+	/**
+	 * @brief Records a running program that was adopted or recovered.
+	 */
+	static void Tracked(const std::string &loadout,
+			    const std::string &program,
+			    unsigned long processId);
+
+	/**
+	 * @brief Marks a program as no longer running.
+	 */
+	static void Stopped(unsigned long processId);
+
+	/**
+	 * @brief Marks a program as suspended or resumed.
+	 */
+	static void SetFrozen(unsigned long processId, bool frozen);
+};
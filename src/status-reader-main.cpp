@@ -0,0 +1,108 @@
+/**
+ * @file status-reader-main.cpp
+ * @brief Reference reader of the status page
+ *
+ * Usage: autostarter-status [--watch <ms>]
+ *
+ * Maps the page read-only once and then reads it with plain memory loads.
+ * Monitors can copy ReadPage() as it is; it only depends on Windows and
+ * status-page-layout.hpp.
+ */
+
+#include <windows.h>
+#include "status-page-layout.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace StatusPageLayout;
+
+/// Copies that keep colliding with the publisher are given up after this
+static const int MaxAttempts = 1000;
+
+/**
+ * @brief Takes a consistent copy of the page under its sequence lock
+ * @return false if the publisher kept writing for every attempt
+ */
+static bool ReadPage(const Page *page, Page &copy)
+{
+	for (int attempt = 0; attempt < MaxAttempts; attempt++) {
+		int64_t before = ReadAcquire64(
+			(const volatile LONG64 *)&page->sequence);
+		if (before & 1) {
+			YieldProcessor();
+			continue;
+		}
+
+		memcpy(&copy, (const void *)page, sizeof(Page));
+
+		// Finish the copy before the sequence is checked again
+		MemoryBarrier();
+		if (ReadNoFence64((const volatile LONG64 *)&page->sequence) ==
+		    before)
+			return true;
+	}
+	return false;
+}
+
+static void Print(const Page &page)
+{
+	if (page.publisherId == 0) {
+		printf("No OBS instance publishes its status\n");
+		return;
+	}
+
+	printf("Published by PID %u, %u programs\n", page.publisherId,
+	       page.programCount);
+	uint32_t count = page.programCount < MaxPrograms ? page.programCount
+							 : MaxPrograms;
+	for (uint32_t i = 0; i < count; i++) {
+		const Program &program = page.programs[i];
+		const char *state = !(program.flags & Running) ? "stopped"
+				    : (program.flags & Frozen) ? "frozen"
+								: "running";
+		printf("  %-20.*s %-24.*s %-8s PID %-6u restarts %-3u launch %llu us\n",
+		       (int)NameLength, program.loadout, (int)NameLength,
+		       program.name, state, program.processId,
+		       program.launches > 0 ? program.launches - 1 : 0,
+		       (unsigned long long)program.launchLatencyUs);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	int watchMs = 0;
+	if (argc == 3 && strcmp(argv[1], "--watch") == 0) {
+		watchMs = atoi(argv[2]);
+	} else if (argc != 1) {
+		fprintf(stderr, "Usage: autostarter-status [--watch <ms>]\n");
+		return 2;
+	}
+
+	HANDLE mapping = OpenFileMappingW(FILE_MAP_READ, FALSE, MappingName);
+	if (!mapping) {
+		fprintf(stderr,
+			"No status page, is OBS with Autostarter running?\n");
+		return 1;
+	}
+	auto page = (const Page *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0,
+						sizeof(Page));
+	if (!page || page->magic != Magic || page->version != Version) {
+		fprintf(stderr, "Unsupported status page\n");
+		return 1;
+	}
+
+	Page copy;
+	do {
+		if (ReadPage(page, copy))
+			Print(copy);
+		else
+			fprintf(stderr, "Status page stayed busy\n");
+		if (watchMs > 0)
+			Sleep((DWORD)watchMs);
+	} while (watchMs > 0);
+
+	UnmapViewOfFile(page);
+	CloseHandle(mapping);
+	return 0;
+}
@@ -0,0 +1,350 @@
+// Supervisor helper that spawns and guards the programs of one OBS instance
+#include <windows.h>
+#include "supervisor-protocol.hpp"
+#include "launch-registry.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <cwchar>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace SupervisorProtocol;
+
+namespace {
+
+struct TrackedProcess {
+	DWORD processId;
+	HANDLE handle;
+};
+
+HANDLE obsProcess = nullptr;
+HANDLE stopEvent = nullptr; ///< Set once OBS says goodbye on any pipe
+std::mutex trackedMutex;    ///< Guards tracked and autoclose
+std::vector<TrackedProcess> tracked;
+bool autoclose = false;
+
+/**
+ * @brief Stops tracking a process and closes its handle. Requires
+ * trackedMutex.
+ */
+void Forget(DWORD processId)
+{
+	auto it = std::find_if(tracked.begin(), tracked.end(),
+			       [&](const TrackedProcess &process) {
+				       return process.processId == processId;
+			       });
+	if (it == tracked.end())
+		return;
+	CloseHandle(it->handle);
+	tracked.erase(it);
+}
+
+/**
+ * @brief Drops processes that exited on their own. Requires trackedMutex.
+ */
+void Prune()
+{
+	auto it = std::remove_if(tracked.begin(), tracked.end(),
+				 [](const TrackedProcess &process) {
+					 if (WaitForSingleObject(process.handle,
+								 0) !=
+					     WAIT_OBJECT_0)
+						 return false;
+					 CloseHandle(process.handle);
+					 return true;
+				 });
+	tracked.erase(it, tracked.end());
+}
+
+Response Spawn(const Request &request, const wchar_t *payload,
+	       size_t payloadLength)
+{
+	Response response;
+	const wchar_t *workingDirectory = payload + request.commandLineLength;
+	const wchar_t *environment =
+		workingDirectory + request.workingDirectoryLength;
+
+	// Every string has to be complete and terminated
+	if (request.commandLineLength == 0 ||
+	    (size_t)request.commandLineLength +
+			    request.workingDirectoryLength +
+			    request.environmentLength !=
+		    payloadLength ||
+	    payload[request.commandLineLength - 1] != L'\0' ||
+	    (request.workingDirectoryLength &&
+	     workingDirectory[request.workingDirectoryLength - 1] != L'\0') ||
+	    (request.environmentLength &&
+	     (request.environmentLength < 2 ||
+	      environment[request.environmentLength - 1] != L'\0' ||
+	      environment[request.environmentLength - 2] != L'\0'))) {
+		response.errorCode = ERROR_INVALID_DATA;
+		return response;
+	}
+
+	std::vector<wchar_t> commandLine(payload,
+					 payload + request.commandLineLength);
+	STARTUPINFOW si = {sizeof(si)};
+	if (request.flags & SpawnMinimized) {
+		si.dwFlags = STARTF_USESHOWWINDOW;
+		si.wShowWindow = SW_SHOWMINIMIZED;
+	}
+
+	PROCESS_INFORMATION pi;
+	if (!CreateProcessW(
+		    nullptr, commandLine.data(), nullptr, nullptr, FALSE,
+		    request.environmentLength ? CREATE_UNICODE_ENVIRONMENT : 0,
+		    request.environmentLength ? (LPVOID)environment : nullptr,
+		    request.workingDirectoryLength ? workingDirectory : nullptr,
+		    &si, &pi)) {
+		response.errorCode = GetLastError();
+		return response;
+	}
+	CloseHandle(pi.hThread);
+
+	// OBS tracks the program through its own copy of the handle
+	HANDLE duplicate = nullptr;
+	if (!DuplicateHandle(GetCurrentProcess(), pi.hProcess, obsProcess,
+			     &duplicate, 0, FALSE, DUPLICATE_SAME_ACCESS)) {
+		response.errorCode = GetLastError();
+		TerminateProcess(pi.hProcess, 0);
+		CloseHandle(pi.hProcess);
+		return response;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(trackedMutex);
+		tracked.push_back({pi.dwProcessId, pi.hProcess});
+	}
+	response.ok = 1;
+	response.processId = pi.dwProcessId;
+	response.processHandle = (uint64_t)(uintptr_t)duplicate;
+	return response;
+}
+
+Response Quit(DWORD processId)
+{
+	Response response;
+	auto it = std::find_if(tracked.begin(), tracked.end(),
+			       [&](const TrackedProcess &process) {
+				       return process.processId == processId;
+			       });
+	if (it == tracked.end()) {
+		response.errorCode = ERROR_NOT_FOUND;
+		return response;
+	}
+
+	if (TerminateProcess(it->handle, 0))
+		response.ok = 1;
+	else
+		response.errorCode = GetLastError();
+	Forget(processId);
+	return response;
+}
+
+Response Adopt(DWORD processId)
+{
+	Response response;
+	HANDLE process =
+		OpenProcess(PROCESS_TERMINATE | SYNCHRONIZE, FALSE, processId);
+	if (!process) {
+		response.errorCode = GetLastError();
+		return response;
+	}
+
+	Forget(processId);
+	tracked.push_back({processId, process});
+	response.ok = 1;
+	response.processId = processId;
+	return response;
+}
+
+Response Dispatch(const Request &request, const wchar_t *payload,
+		size_t payloadLength)
+{
+	// Spawns of several pipes run at once, only bookkeeping is serialized
+	if (request.command == Command::Spawn)
+		return Spawn(request, payload, payloadLength);
+
+	std::lock_guard<std::mutex> lock(trackedMutex);
+	Prune();
+
+	Response response;
+	switch (request.command) {
+	case Command::Quit:
+		return Quit(request.processId);
+	case Command::Release:
+		Forget(request.processId);
+		response.ok = 1;
+		break;
+	case Command::Adopt:
+		return Adopt(request.processId);
+	case Command::SetAutoclose:
+		autoclose = request.flags != 0;
+		response.ok = 1;
+		break;
+	case Command::Exit:
+		response.ok = 1;
+		break;
+	default:
+		response.errorCode = ERROR_INVALID_FUNCTION;
+		break;
+	}
+	return response;
+}
+
+/**
+ * @brief Waits for an overlapped pipe operation unless OBS exits or says
+ * goodbye on another pipe first.
+ */
+bool Complete(HANDLE pipe, OVERLAPPED &overlapped, DWORD &bytes)
+{
+	HANDLE waits[] = {obsProcess, stopEvent, overlapped.hEvent};
+	if (WaitForMultipleObjects(3, waits, FALSE, INFINITE) !=
+	    WAIT_OBJECT_0 + 2) {
+		CancelIo(pipe);
+		return false;
+	}
+	return GetOverlappedResult(pipe, &overlapped, &bytes, FALSE);
+}
+
+/**
+ * @brief Answers the requests of OBS until it says goodbye.
+ * @return true after an orderly Exit, false if OBS exited or the pipe broke.
+ */
+bool Serve(HANDLE pipe, DWORD obsProcessId)
+{
+	OVERLAPPED overlapped = {};
+	overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+	if (!overlapped.hEvent)
+		return false;
+
+	DWORD bytes = 0;
+	bool connected = ConnectNamedPipe(pipe, &overlapped) ||
+			 GetLastError() == ERROR_PIPE_CONNECTED ||
+			 (GetLastError() == ERROR_IO_PENDING &&
+			  Complete(pipe, overlapped, bytes));
+
+	// Only the OBS instance that started the helper may use it
+	ULONG clientId = 0;
+	bool orderly = false;
+	if (connected && GetNamedPipeClientProcessId(pipe, &clientId) &&
+	    clientId == obsProcessId) {
+		std::vector<char> message(MaxMessageBytes);
+		for (;;) {
+			ResetEvent(overlapped.hEvent);
+			if (!ReadFile(pipe, message.data(),
+				      (DWORD)message.size(), nullptr,
+				      &overlapped) &&
+			    GetLastError() != ERROR_IO_PENDING)
+				break;
+			if (!Complete(pipe, overlapped, bytes) ||
+			    bytes < sizeof(Request))
+				break;
+
+			Request request;
+			memcpy(&request, message.data(), sizeof(request));
+			Response response = Dispatch(
+				request,
+				(const wchar_t *)(message.data() +
+						  sizeof(Request)),
+				(bytes - sizeof(Request)) / sizeof(wchar_t));
+
+			ResetEvent(overlapped.hEvent);
+			if (!WriteFile(pipe, &response, sizeof(response),
+				       nullptr, &overlapped) &&
+			    GetLastError() != ERROR_IO_PENDING)
+				break;
+			if (!Complete(pipe, overlapped, bytes))
+				break;
+
+			if (request.command == Command::Exit) {
+				SetEvent(stopEvent);
+				orderly = true;
+				break;
+			}
+		}
+	}
+
+	CloseHandle(overlapped.hEvent);
+	return orderly;
+}
+
+} // namespace
+
+/**
+ * @brief Entry point, the only argument is the process ID of OBS.
+ */
+int WINAPI wWinMain(HINSTANCE, HINSTANCE, PWSTR commandLine, int)
+{
+	DWORD obsProcessId = wcstoul(commandLine, nullptr, 10);
+	obsProcess = OpenProcess(SYNCHRONIZE | PROCESS_DUP_HANDLE, FALSE,
+				 obsProcessId);
+	if (!obsProcess)
+		return 1;
+
+	std::wstring pipeName = PipePrefix + std::to_wstring(obsProcessId);
+	std::vector<HANDLE> pipes;
+	for (uint32_t i = 0; i < PipeInstances; i++) {
+		HANDLE pipe = CreateNamedPipeW(
+			pipeName.c_str(),
+			PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED |
+				(i == 0 ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0),
+			PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT |
+				PIPE_REJECT_REMOTE_CLIENTS,
+			PipeInstances, sizeof(Response), MaxMessageBytes, 0,
+			nullptr);
+		if (pipe == INVALID_HANDLE_VALUE)
+			break;
+		pipes.push_back(pipe);
+	}
+	stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+	if (pipes.empty() || !stopEvent) {
+		for (HANDLE pipe : pipes)
+			CloseHandle(pipe);
+		CloseHandle(obsProcess);
+		return 1;
+	}
+
+	std::atomic<bool> orderly{false};
+	std::vector<std::thread> servers;
+	for (HANDLE pipe : pipes) {
+		servers.emplace_back([pipe, obsProcessId, &orderly]() {
+			if (Serve(pipe, obsProcessId))
+				orderly = true;
+		});
+	}
+	for (auto &server : servers)
+		server.join();
+	for (HANDLE pipe : pipes)
+		CloseHandle(pipe);
+	CloseHandle(stopEvent);
+
+	if (!orderly) {
+		// OBS crashed or lost us, enforce its policy once it is gone
+		WaitForSingleObject(obsProcess, INFINITE);
+		Prune();
+		// Spare programs that another running instance still uses
+		if (autoclose) {
+			bool shared = LaunchRegistry::Open();
+			for (const auto &process : tracked) {
+				int entry = shared ? LaunchRegistry::Find(
+							     process.processId)
+						   : -1;
+				if (LaunchRegistry::BeginTerminate(entry) !=
+				    LaunchRegistry::Termination::Terminate)
+					continue;
+				TerminateProcess(process.handle, 0);
+				LaunchRegistry::EndTerminate(entry);
+			}
+			LaunchRegistry::Close();
+		}
+	}
+
+	for (const auto &process : tracked)
+		CloseHandle(process.handle);
+	CloseHandle(obsProcess);
+	return 0;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * @brief Messages exchanged between the plugin and the supervisor helper.
+ *
+ * The helper listens on a local message-mode named pipe that carries the
+ * process ID of the OBS instance it serves. The pipe has PipeInstances
+ * instances, each served on its own thread, so OBS can have that many
+ * requests in flight. Every request is answered with exactly one Response
+ * on the instance it arrived on. Spawn requests are followed by the command line,
+ * working directory and environment block as consecutive wide strings.
+ */
+namespace SupervisorProtocol {
+
+/// File name of the helper, installed next to the plugin module
+inline constexpr wchar_t HelperName[] = L"autostarter-supervisor.exe";
+
+/// Pipe name prefix, followed by the decimal OBS process ID
+inline constexpr wchar_t PipePrefix[] = L"\\\\.\\pipe\\obs-autostarter-supervisor-";
+
+/// Connections per OBS instance, e.g. for spawns that run in parallel
+inline constexpr uint32_t PipeInstances = 4;
+
+/// Largest request the helper accepts, enough for a full environment block
+inline constexpr uint32_t MaxMessageBytes = 256 * 1024;
+
+enum class Command : uint32_t {
+	Spawn,        ///< Start a program and track it
+	Quit,         ///< Terminate a tracked program
+	Release,      ///< Stop tracking a program but keep it running
+	Adopt,        ///< Track a program that is already running
+	SetAutoclose, ///< Whether tracked programs quit if OBS exits without saying goodbye
+	Exit          ///< Orderly shutdown, tracked programs are left alone
+};
+
+enum SpawnFlags : uint32_t {
+	SpawnMinimized = 1 << 0
+};
+
+struct Request {
+	Command command;
+	uint32_t processId = 0;              ///< Quit, Release and Adopt
+	uint32_t flags = 0;                  ///< SpawnFlags, or 1 to enable SetAutoclose
+	uint32_t commandLineLength = 0;      ///< In characters including the terminator
+	uint32_t workingDirectoryLength = 0; ///< In characters including the terminator, 0 for none
+	uint32_t environmentLength = 0;      ///< In characters including both terminators, 0 to inherit
+};
+
+struct Response {
+	uint32_t ok = 0;
+	uint32_t processId = 0;     ///< Spawn: ID of the new process
+	uint32_t errorCode = 0;     ///< Windows error code if ok is 0
+	uint64_t processHandle = 0; ///< Spawn: process handle duplicated into the OBS process
+};
+
+} // namespace SupervisorProtocol
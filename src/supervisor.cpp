@@ -0,0 +1,410 @@
+// Talks to the supervisor helper that spawns and guards launched programs
+#include <windows.h>
+#include "supervisor.hpp"
+#include "supervisor-protocol.hpp"
+#include "launch-plan.hpp"
+#include "config.hpp"
+#include "constants.hpp"
+#include <QDir>
+#include <QString>
+#include "host.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace SupervisorProtocol;
+
+namespace {
+
+/**
+ * @brief One connected instance of the helper pipe.
+ */
+struct Connection {
+	HANDLE pipe = INVALID_HANDLE_VALUE;
+	HANDLE event = nullptr; ///< Completes the overlapped I/O
+};
+
+std::mutex pipeMutex; ///< Guards the helper state and the connection pool
+std::condition_variable poolChanged; ///< Signaled when a connection returns or the connector is done
+HANDLE helper = nullptr; ///< Helper process, nullptr if it is not available
+std::vector<Connection> idle; ///< Connections not in use, requires pipeMutex
+std::thread connector; ///< Connects to the helper after Start()
+bool connecting = false; ///< Requires pipeMutex
+std::vector<DWORD> pendingAdopts; ///< Adopted while connecting, requires pipeMutex
+
+void CloseConnection(const Connection &connection)
+{
+	if (connection.pipe != INVALID_HANDLE_VALUE)
+		CloseHandle(connection.pipe);
+	if (connection.event)
+		CloseHandle(connection.event);
+}
+
+/**
+ * @brief Forgets the helper so the plugin falls back to spawning itself.
+ * Connections in use are closed when they are returned. Requires pipeMutex.
+ */
+void Abandon()
+{
+	for (const auto &connection : idle)
+		CloseConnection(connection);
+	idle.clear();
+	if (helper) {
+		CloseHandle(helper);
+		helper = nullptr;
+	}
+	poolChanged.notify_all();
+}
+
+/**
+ * @brief Finishes an overlapped operation, giving up after
+ * Constants::SUPERVISOR_TIMEOUT_MS so a stalled helper cannot hang OBS.
+ */
+bool Complete(const Connection &connection, OVERLAPPED &overlapped,
+	      DWORD &bytes)
+{
+	if (WaitForSingleObject(connection.event,
+				Constants::SUPERVISOR_TIMEOUT_MS) !=
+	    WAIT_OBJECT_0) {
+		CancelIoEx(connection.pipe, &overlapped);
+		// The buffers must outlive the cancelled operation
+		GetOverlappedResult(connection.pipe, &overlapped, &bytes, TRUE);
+		SetLastError(WAIT_TIMEOUT);
+		return false;
+	}
+	return GetOverlappedResult(connection.pipe, &overlapped, &bytes,
+				   FALSE);
+}
+
+/**
+ * @brief Sends one request over a connection and reads the response.
+ * Runs without pipeMutex, so requests on other connections go on.
+ */
+bool Exchange(const Connection &connection, const Request &request,
+	      const std::vector<wchar_t> &payload, Response &response)
+{
+	std::vector<char> message(sizeof(Request) +
+				  payload.size() * sizeof(wchar_t));
+	memcpy(message.data(), &request, sizeof(Request));
+	if (!payload.empty())
+		memcpy(message.data() + sizeof(Request), payload.data(),
+		       payload.size() * sizeof(wchar_t));
+
+	OVERLAPPED overlapped = {};
+	overlapped.hEvent = connection.event;
+	DWORD bytes = 0;
+	bool ok = (WriteFile(connection.pipe, message.data(),
+			     (DWORD)message.size(), nullptr, &overlapped) ||
+		   GetLastError() == ERROR_IO_PENDING) &&
+		  Complete(connection, overlapped, bytes);
+	if (ok) {
+		overlapped = {};
+		overlapped.hEvent = connection.event;
+		ok = (ReadFile(connection.pipe, &response, sizeof(response),
+			       nullptr, &overlapped) ||
+		      GetLastError() == ERROR_IO_PENDING) &&
+		     Complete(connection, overlapped, bytes) &&
+		     bytes == sizeof(response);
+	}
+	if (!ok)
+		Host::Log(Host::Warning,
+			  "Lost the connection to the supervisor, error code: %lu",
+			  GetLastError());
+	return ok;
+}
+
+/**
+ * @brief Takes an idle connection, waiting while all of them are busy.
+ * Requires pipeMutex.
+ * @param waitForConnector Whether to wait while the helper is connecting.
+ * @return false if the helper is not available.
+ */
+bool TakeConnection(std::unique_lock<std::mutex> &lock,
+		    bool waitForConnector, Connection &connection)
+{
+	poolChanged.wait(lock, [waitForConnector] {
+		return (connecting && !waitForConnector) ||
+		       (!connecting && (!helper || !idle.empty()));
+	});
+	if (connecting || !helper)
+		return false;
+
+	connection = idle.back();
+	idle.pop_back();
+	return true;
+}
+
+/**
+ * @brief Puts a connection back, or closes it if it failed or the helper
+ * was abandoned in the meantime. Requires pipeMutex.
+ */
+void ReturnConnection(const Connection &connection, bool ok)
+{
+	if (ok && helper)
+		idle.push_back(connection);
+	else
+		CloseConnection(connection);
+	poolChanged.notify_all();
+}
+
+/**
+ * @brief Sends one request if the helper is connected. A connection that
+ * fails or times out abandons the helper.
+ * @param waitForConnector Whether to wait while the helper is connecting.
+ */
+bool Send(const Request &request, const std::vector<wchar_t> &payload,
+	  Response &response, bool waitForConnector = false)
+{
+	Connection connection;
+	{
+		std::unique_lock<std::mutex> lock(pipeMutex);
+		if (!TakeConnection(lock, waitForConnector, connection))
+			return false;
+	}
+
+	bool ok = Exchange(connection, request, payload, response);
+
+	std::lock_guard<std::mutex> lock(pipeMutex);
+	if (!ok)
+		Abandon();
+	ReturnConnection(connection, ok);
+	return ok;
+}
+
+/**
+ * @brief Opens one instance of the helper pipe, waiting while the helper
+ * is still creating it.
+ */
+bool OpenConnection(const std::wstring &name, Connection &connection)
+{
+	for (int attempt = 0; attempt < 20; attempt++) {
+		if (WaitForSingleObject(helper, 0) == WAIT_OBJECT_0)
+			break;
+		connection.pipe = CreateFileW(name.c_str(),
+					      GENERIC_READ | GENERIC_WRITE, 0,
+					      nullptr, OPEN_EXISTING,
+					      FILE_FLAG_OVERLAPPED, nullptr);
+		if (connection.pipe != INVALID_HANDLE_VALUE)
+			break;
+		if (GetLastError() == ERROR_PIPE_BUSY)
+			WaitNamedPipeW(name.c_str(), 100);
+		else
+			Sleep(50);
+	}
+
+	// Only talk to the helper this instance started
+	ULONG serverId = 0;
+	if (connection.pipe == INVALID_HANDLE_VALUE ||
+	    !GetNamedPipeServerProcessId(connection.pipe, &serverId) ||
+	    serverId != GetProcessId(helper))
+		return false;
+
+	DWORD mode = PIPE_READMODE_MESSAGE;
+	SetNamedPipeHandleState(connection.pipe, &mode, nullptr, nullptr);
+	connection.event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+	return connection.event != nullptr;
+}
+
+/**
+ * @brief Connects every pipe instance once the helper is up and hands it
+ * the autoclose policy and the programs adopted in the meantime. Runs on
+ * the connector thread, so waiting for the pipe blocks neither the UI nor
+ * other requests.
+ */
+void Connect()
+{
+	std::wstring name = PipePrefix + std::to_wstring(GetCurrentProcessId());
+	std::vector<Connection> connections;
+	for (uint32_t i = 0; i < PipeInstances; i++) {
+		Connection connection;
+		if (!OpenConnection(name, connection)) {
+			CloseConnection(connection);
+			break;
+		}
+		connections.push_back(connection);
+	}
+
+	std::unique_lock<std::mutex> lock(pipeMutex);
+	connecting = false;
+	bool ok = !connections.empty();
+	if (ok) {
+		Request request{Command::SetAutoclose};
+		request.flags = PluginConfig::Get().Snapshot()->autoclose ? 1
+									   : 0;
+		Response response;
+		ok = Exchange(connections.front(), request, {}, response);
+		for (DWORD processId : pendingAdopts) {
+			if (!ok)
+				break;
+			Request adopt{Command::Adopt};
+			adopt.processId = processId;
+			ok = Exchange(connections.front(), adopt, {}, response);
+		}
+	}
+	pendingAdopts.clear();
+
+	if (ok) {
+		idle = std::move(connections);
+	} else {
+		Host::Log(Host::Warning,
+			  "Could not connect to the supervisor, launching programs from OBS");
+		for (const auto &connection : connections)
+			CloseConnection(connection);
+		Abandon();
+	}
+	lock.unlock();
+	poolChanged.notify_all();
+}
+
+/**
+ * @brief Drops a program adopted while connecting. Requires pipeMutex.
+ */
+void ForgetPending(DWORD processId)
+{
+	pendingAdopts.erase(std::remove(pendingAdopts.begin(),
+					pendingAdopts.end(), processId),
+			    pendingAdopts.end());
+}
+
+} // namespace
+
+void Supervisor::Start(const std::string &helperDirectory)
+{
+	QString directory = QString::fromStdString(helperDirectory);
+	std::wstring helperPath =
+		QDir::toNativeSeparators(directory).toStdWString() + L"\\" +
+		HelperName;
+	std::wstring commandLine = L"\"" + helperPath + L"\" " +
+				   std::to_wstring(GetCurrentProcessId());
+
+	STARTUPINFOW si = {sizeof(si)};
+	PROCESS_INFORMATION pi;
+	// Leave the job object OBS may run in, so the helper outlives a crash
+	DWORD creationFlags = CREATE_NO_WINDOW | CREATE_BREAKAWAY_FROM_JOB;
+	BOOL created = CreateProcessW(helperPath.c_str(), commandLine.data(),
+				      nullptr, nullptr, FALSE, creationFlags,
+				      nullptr, nullptr, &si, &pi);
+	if (!created && GetLastError() == ERROR_ACCESS_DENIED) {
+		creationFlags &= ~CREATE_BREAKAWAY_FROM_JOB;
+		created = CreateProcessW(helperPath.c_str(), commandLine.data(),
+					 nullptr, nullptr, FALSE,
+					 creationFlags, nullptr, nullptr, &si,
+					 &pi);
+	}
+	if (!created) {
+		Host::Log(Host::Warning,
+			  "Failed to start the supervisor, error code: %lu",
+			  GetLastError());
+		return;
+	}
+
+	CloseHandle(pi.hThread);
+	std::lock_guard<std::mutex> lock(pipeMutex);
+	helper = pi.hProcess;
+	connecting = true;
+	connector = std::thread(Connect);
+	Host::Log(Host::Info, "Started the supervisor (PID %lu)",
+		  pi.dwProcessId);
+}
+
+bool Supervisor::Spawn(const LaunchPlan &plan, HANDLE &process,
+		       unsigned long &processId, unsigned long &errorCode)
+{
+	Request request{Command::Spawn};
+	request.flags = plan.minimized ? SpawnMinimized : 0;
+
+	std::vector<wchar_t> payload(plan.commandLine.begin(),
+				     plan.commandLine.end());
+	request.commandLineLength = (uint32_t)plan.commandLine.size();
+	if (!plan.workingDirectory.empty()) {
+		payload.insert(payload.end(), plan.workingDirectory.begin(),
+			       plan.workingDirectory.end());
+		payload.push_back(L'\0');
+		request.workingDirectoryLength =
+			(uint32_t)plan.workingDirectory.size() + 1;
+	}
+	payload.insert(payload.end(), plan.environment.begin(),
+		       plan.environment.end());
+	request.environmentLength = (uint32_t)plan.environment.size();
+
+	// Oversized requests are launched from OBS instead
+	if (sizeof(Request) + payload.size() * sizeof(wchar_t) >
+	    MaxMessageBytes)
+		return false;
+
+	// Launches right after Start() wait until the helper is up
+	Response response;
+	if (!Send(request, payload, response, true))
+		return false;
+
+	process = response.ok ? (HANDLE)(uintptr_t)response.processHandle
+			      : nullptr;
+	processId = response.processId;
+	errorCode = response.errorCode;
+	return true;
+}
+
+bool Supervisor::Quit(unsigned long processId)
+{
+	Request request{Command::Quit};
+	request.processId = processId;
+	Response response;
+	{
+		std::lock_guard<std::mutex> lock(pipeMutex);
+		ForgetPending(processId);
+	}
+	return Send(request, {}, response) && response.ok;
+}
+
+void Supervisor::Release(unsigned long processId)
+{
+	Request request{Command::Release};
+	request.processId = processId;
+	Response response;
+	{
+		std::lock_guard<std::mutex> lock(pipeMutex);
+		ForgetPending(processId);
+	}
+	Send(request, {}, response);
+}
+
+void Supervisor::Adopt(unsigned long processId)
+{
+	Request request{Command::Adopt};
+	request.processId = processId;
+	{
+		std::lock_guard<std::mutex> lock(pipeMutex);
+		// The connector hands it over once the helper is up
+		if (connecting) {
+			pendingAdopts.push_back(processId);
+			return;
+		}
+	}
+	Response response;
+	Send(request, {}, response);
+}
+
+void Supervisor::SetAutoclose(bool autoclose)
+{
+	Request request{Command::SetAutoclose};
+	request.flags = autoclose ? 1 : 0;
+	// A later connection picks the policy up from the config
+	Response response;
+	Send(request, {}, response);
+}
+
+void Supervisor::Stop()
+{
+	if (connector.joinable())
+		connector.join();
+
+	// An unconnected helper exits on its own once OBS is gone
+	Response response;
+	Send(Request{Command::Exit}, {}, response);
+
+	std::lock_guard<std::mutex> lock(pipeMutex);
+	Abandon();
+}
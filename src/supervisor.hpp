@@ -0,0 +1,68 @@
+#pragma once
+#include <string>
+
+// Forward declare Windows types
+using HANDLE = void *;
+
+struct LaunchPlan;
+
+/**
+ * @brief Client of the out-of-process supervisor helper.
+ *
+ * The helper is started at the very beginning of plugin load while OBS is
+ * still small, so creating processes from it stays cheap. It spawns and
+ * tracks programs on request and, if OBS exits without an orderly
+ * shutdown, quits them when autoclose is enabled. When the helper is not
+ * available every call reports so and the plugin falls back to spawning
+ * programs itself. A helper that does not answer within
+ * Constants::SUPERVISOR_TIMEOUT_MS is given up the same way. Requests use
+ * a pool of pipe connections, so concurrent launches do not queue behind
+ * each other.
+ */
+class Supervisor {
+public:
+	/**
+	 * @brief Starts the helper and connects to it in the background.
+	 * @param helperDirectory Directory holding the helper executable.
+	 */
+	static void Start(const std::string &helperDirectory);
+
+	/**
+	 * @brief Asks the helper to spawn a program.
+	 * @param plan The compiled program, must use LaunchMethod::Spawn.
+	 * @param process Receives a handle to the new process, nullptr on failure.
+	 * @param processId Receives the ID of the new process.
+	 * @param errorCode Receives the Windows error code on failure.
+	 * @return true if the helper handled the request, false if it is unavailable.
+	 */
+	static bool Spawn(const LaunchPlan &plan, HANDLE &process,
+			  unsigned long &processId, unsigned long &errorCode);
+
+	/**
+	 * @brief Asks the helper to terminate a program it tracks.
+	 * @return true if the program was terminated by the helper.
+	 */
+	static bool Quit(unsigned long processId);
+
+	/**
+	 * @brief Tells the helper to forget a program that keeps running.
+	 */
+	static void Release(unsigned long processId);
+
+	/**
+	 * @brief Hands a running program to the helper, e.g. after crash recovery.
+	 * Never waits for the helper, programs adopted before it is connected
+	 * are handed over once it is.
+	 */
+	static void Adopt(unsigned long processId);
+
+	/**
+	 * @brief Updates the autoclose policy the helper enforces if OBS dies.
+	 */
+	static void SetAutoclose(bool autoclose);
+
+	/**
+	 * @brief Shuts the helper down in order. Call after tracked programs were quit or released.
+	 */
+	static void Stop();
+};
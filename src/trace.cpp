@@ -0,0 +1,163 @@
+// Records launch timeline spans and exports them as Chrome trace-event JSON
+#include <windows.h>
+#include "trace.hpp"
+#include "constants.hpp"
+#include "host.hpp"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QString>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+namespace {
+
+/**
+ * @brief A single recorded event. Fixed size so recording never allocates.
+ */
+struct TraceEvent {
+	const char *name;
+	const char *category;
+	uint64_t startNs;
+	uint64_t endNs; ///< Equal to startNs for instant events
+	unsigned long threadId;
+	bool instant;
+	char detail[64];
+	/// Set once the fields above are written, Write() skips the slot until then
+	std::atomic<bool> ready;
+};
+
+std::unique_ptr<TraceEvent[]> events;
+std::atomic<size_t> eventCount{0};
+
+void Record(const char *name, const char *category, uint64_t startNs,
+	    uint64_t endNs, bool instant, const char *detail)
+{
+	size_t slot = eventCount.fetch_add(1, std::memory_order_relaxed);
+	if (slot >= Constants::TRACE_BUFFER_SIZE)
+		return;
+
+	TraceEvent &event = events[slot];
+	event.name = name;
+	event.category = category;
+	event.startNs = startNs;
+	event.endNs = endNs;
+	event.threadId = GetCurrentThreadId();
+	event.instant = instant;
+	event.detail[0] = '\0';
+	if (detail) {
+		strncpy(event.detail, detail, sizeof(event.detail) - 1);
+		event.detail[sizeof(event.detail) - 1] = '\0';
+	}
+	event.ready.store(true, std::memory_order_release);
+}
+
+} // namespace
+
+std::atomic<bool> Trace::enabled{false};
+
+void Trace::Enable()
+{
+	if (IsEnabled())
+		return;
+
+	events = std::make_unique<TraceEvent[]>(Constants::TRACE_BUFFER_SIZE);
+	eventCount = 0;
+	enabled.store(true, std::memory_order_release);
+	Host::Log(Host::Info, "Launch tracing enabled");
+}
+
+uint64_t Trace::Now()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		       std::chrono::steady_clock::now().time_since_epoch())
+		.count();
+}
+
+void Trace::AddSpan(const char *name, const char *category, uint64_t startNs,
+		    uint64_t endNs, const char *detail)
+{
+	if (IsEnabled())
+		Record(name, category, startNs, endNs, false, detail);
+}
+
+void Trace::AddInstant(const char *name, const char *category,
+		       const char *detail)
+{
+	if (IsEnabled()) {
+		uint64_t now = Now();
+		Record(name, category, now, now, true, detail);
+	}
+}
+
+bool Trace::Write(const std::string &path)
+{
+	if (!IsEnabled())
+		return false;
+
+	size_t recorded = eventCount.load(std::memory_order_acquire);
+	size_t count = std::min(recorded, Constants::TRACE_BUFFER_SIZE);
+	if (recorded > count) {
+		Host::Log(Host::Warning,
+			  "Trace buffer full, dropped %zu events",
+			  recorded - count);
+	}
+
+	QJsonArray traceEvents;
+	qint64 processId = GetCurrentProcessId();
+	size_t unfinished = 0;
+	for (size_t i = 0; i < count; i++) {
+		const TraceEvent &event = events[i];
+		// Claimed by a thread that is still writing it
+		if (!event.ready.load(std::memory_order_acquire)) {
+			unfinished++;
+			continue;
+		}
+		QJsonObject obj;
+		obj["name"] = event.name;
+		obj["cat"] = event.category;
+		obj["ph"] = event.instant ? "i" : "X";
+		obj["ts"] = (double)event.startNs / 1000.0;
+		if (event.instant)
+			obj["s"] = "t";
+		else
+			obj["dur"] = (double)(event.endNs - event.startNs) /
+				     1000.0;
+		obj["pid"] = processId;
+		obj["tid"] = (qint64)event.threadId;
+		if (event.detail[0]) {
+			QJsonObject args;
+			args["detail"] = QString::fromUtf8(event.detail);
+			obj["args"] = args;
+		}
+		traceEvents.append(obj);
+	}
+	if (unfinished > 0) {
+		Host::Log(Host::Warning,
+			  "Skipped %zu trace events still being recorded",
+			  unfinished);
+	}
+
+	QJsonObject root;
+	root["traceEvents"] = traceEvents;
+	root["displayTimeUnit"] = "ms";
+
+	QString filePath = QString::fromStdString(path);
+	QDir().mkpath(QFileInfo(filePath).absolutePath());
+	QFile file(filePath);
+	if (!file.open(QIODevice::WriteOnly)) {
+		Host::Log(Host::Warning, "Failed to write trace to '%s'",
+			  path.c_str());
+		return false;
+	}
+	file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+	Host::Log(Host::Info, "Wrote %zu trace events to '%s'",
+		  count - unfinished, path.c_str());
+	return true;
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Opt-in recorder for launch timeline spans.
+ *
+ * Events are stored in a buffer that is allocated once when tracing is
+ * enabled and written out as Chrome trace-event JSON, which can be opened
+ * in Perfetto or chrome://tracing. While disabled, every call reduces to a
+ * single atomic load.
+ */
+class Trace {
+public:
+	/**
+	 * @brief Allocates the event buffer and starts recording.
+	 */
+	static void Enable();
+
+	/**
+	 * @brief Returns whether events are currently recorded.
+	 */
+	static bool IsEnabled()
+	{
+		return enabled.load(std::memory_order_acquire);
+	}
+
+	/**
+	 * @brief Returns the current trace clock in nanoseconds.
+	 */
+	static uint64_t Now();
+
+	/**
+	 * @brief Records a completed span.
+	 * @param name Static span name.
+	 * @param category Static category name.
+	 * @param startNs Start time from Now().
+	 * @param endNs End time from Now().
+	 * @param detail Optional detail, copied into the event and truncated.
+	 */
+	static void AddSpan(const char *name, const char *category,
+			    uint64_t startNs, uint64_t endNs,
+			    const char *detail = nullptr);
+
+	/**
+	 * @brief Records a point in time, such as a program becoming ready.
+	 * @param name Static event name.
+	 * @param category Static category name.
+	 * @param detail Optional detail, copied into the event and truncated.
+	 */
+	static void AddInstant(const char *name, const char *category,
+			       const char *detail = nullptr);
+
+	/**
+	 * @brief Writes all recorded events as Chrome trace-event JSON.
+	 * @param path Destination file.
+	 * @return true if the file was written.
+	 */
+	static bool Write(const std::string &path);
+
+private:
+	static std::atomic<bool> enabled;
+};
+
+/**
+ * @brief Records a span covering its own lifetime when tracing is enabled.
+ */
+class TraceSpan {
+public:
+	TraceSpan(const char *name, const char *category,
+		  const char *detail = nullptr)
+		: name(name),
+		  category(category),
+		  detail(detail),
+		  start(Trace::IsEnabled() ? Trace::Now() : 0)
+	{
+	}
+
+	~TraceSpan()
+	{
+		if (start != 0)
+			Trace::AddSpan(name, category, start, Trace::Now(),
+				       detail);
+	}
+
+	TraceSpan(const TraceSpan &) = delete;
+	TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+	const char *name;
+	const char *category;
+	const char *detail;
+	uint64_t start;
+};
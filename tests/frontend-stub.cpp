@@ -0,0 +1,31 @@
+/**
+ * @file frontend-stub.cpp
+ * @brief Stand-in for obs-frontend-api.dll in the headless tests
+ *
+ * Built under the name of the real library and placed next to the plugin,
+ * so the plugin resolves its frontend imports here. No output is active and
+ * callbacks are never invoked.
+ */
+
+#include <obs-frontend-api.h>
+
+void obs_frontend_add_tools_menu_item(const char *, obs_frontend_cb, void *) {}
+
+void obs_frontend_add_event_callback(obs_frontend_event_cb, void *) {}
+
+void obs_frontend_remove_event_callback(obs_frontend_event_cb, void *) {}
+
+bool obs_frontend_streaming_active(void)
+{
+	return false;
+}
+
+bool obs_frontend_recording_active(void)
+{
+	return false;
+}
+
+bool obs_frontend_replay_buffer_active(void)
+{
+	return false;
+}
@@ -0,0 +1,91 @@
+// Loads the plugin into a headless libobs for the tests
+#include <windows.h>
+#include "plugin-host.hpp"
+#include <util/platform.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace {
+
+obs_module_t *module = nullptr;
+
+std::string ExecutableDirectory()
+{
+	char path[MAX_PATH];
+	DWORD length = GetModuleFileNameA(nullptr, path, MAX_PATH);
+	std::string directory(path, length);
+	return directory.substr(0, directory.find_last_of("\\/") + 1);
+}
+
+} // namespace
+
+bool PluginHost::Start()
+{
+	char tempPath[MAX_PATH];
+	GetTempPathA(MAX_PATH, tempPath);
+	std::string configPath = std::string(tempPath) + "autostarter-test-" +
+				 std::to_string(GetCurrentProcessId());
+	if (!obs_startup("en-US", configPath.c_str(), nullptr)) {
+		fprintf(stderr, "Failed to start libobs\n");
+		return false;
+	}
+
+	std::string binary = ExecutableDirectory() + PLUGIN_FILE_NAME;
+	int result = obs_open_module(&module, binary.c_str(), nullptr);
+	if (result != MODULE_SUCCESS) {
+		fprintf(stderr, "Failed to open '%s' (%d)\n", binary.c_str(),
+			result);
+		return false;
+	}
+	return true;
+}
+
+bool PluginHost::WriteConfig(const char *json)
+{
+	if (!module)
+		return false;
+
+	char *path = obs_module_get_config_path(module, "config.json");
+	if (!path)
+		return false;
+
+	std::string directory = path;
+	directory = directory.substr(0, directory.find_last_of("\\/"));
+	bool written = os_mkdirs(directory.c_str()) != MKDIR_ERROR &&
+		       os_quick_write_utf8_file(path, json, strlen(json),
+						false);
+	bfree(path);
+	return written;
+}
+
+bool PluginHost::Load()
+{
+	return module && obs_init_module(module);
+}
+
+void PluginHost::Stop()
+{
+	// Unloads every initialized module
+	obs_shutdown();
+	module = nullptr;
+}
+
+std::string PluginHost::Directory()
+{
+	return ExecutableDirectory();
+}
+
+size_t PluginHost::LiveHeapBlocks()
+{
+	HANDLE heap = GetProcessHeap();
+	size_t blocks = 0;
+	PROCESS_HEAP_ENTRY entry = {};
+	HeapLock(heap);
+	while (HeapWalk(heap, &entry)) {
+		if (entry.wFlags & PROCESS_HEAP_ENTRY_BUSY)
+			blocks++;
+	}
+	HeapUnlock(heap);
+	return blocks;
+}
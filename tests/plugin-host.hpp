@@ -0,0 +1,50 @@
+#pragma once
+#include <obs.h>
+#include <string>
+
+/**
+ * @brief Runs libobs headless with the plugin loaded against the stub frontend.
+ *
+ * The plugin binary and the stub obs-frontend-api library are copied next
+ * to the test executable by the build. The plugin keeps its config in a
+ * fresh folder under the temp directory.
+ */
+class PluginHost {
+public:
+	/**
+	 * @brief Starts libobs and opens the plugin without initializing it.
+	 * @return true if the plugin binary could be opened.
+	 */
+	static bool Start();
+
+	/**
+	 * @brief Writes the config file the plugin reads on load.
+	 * Call between Start() and Load().
+	 * @param json Contents of config.json.
+	 * @return true if the file was written.
+	 */
+	static bool WriteConfig(const char *json);
+
+	/**
+	 * @brief Initializes the plugin, which runs obs_module_load.
+	 * @return true if the plugin loaded.
+	 */
+	static bool Load();
+
+	/**
+	 * @brief Unloads the plugin and shuts libobs down.
+	 */
+	static void Stop();
+
+	/**
+	 * @brief Returns the folder of the test executable with a trailing
+	 * separator, the plugin and the test programs are staged there.
+	 */
+	static std::string Directory();
+
+	/**
+	 * @brief Counts the blocks currently allocated on the process heap,
+	 * which the C runtime of every module allocates from.
+	 */
+	static size_t LiveHeapBlocks();
+};
@@ -0,0 +1,159 @@
+/**
+ * @file procedure-test.cpp
+ * @brief Fails when a call through the libobs procedure API gets too slow
+ *
+ * Loads the plugin headless against the stub frontend with a loadout that
+ * runs procedure-idle.exe, a copy of this test that only waits. Calls
+ * autostarter_status on the global procedure handler in a loop and checks
+ * the mean time per call, which includes the procedure lookup and the
+ * calldata round trip of libobs, against the budget in constants.hpp.
+ * autostarter_launch and autostarter_quit are timed with a real program;
+ * they are dominated by process creation and termination, so their times
+ * are only reported.
+ */
+
+#include <windows.h>
+#include <TlHelp32.h>
+#include "plugin-host.hpp"
+#include "constants.hpp"
+#include <QApplication>
+#include <callback/calldata.h>
+#include <callback/proc.h>
+#include <util/platform.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+/// Enough calls that the clock resolution does not matter
+static const int StatusCalls = 100000;
+/// Every launch starts a process, keep the run short
+static const int LaunchCalls = 20;
+
+static const char IdleProgram[] = "procedure-idle.exe";
+
+/**
+ * @brief Waits until no process of the idle program is left, so the next
+ * launch is not skipped as already running.
+ */
+static bool WaitForIdleExit()
+{
+	for (int attempt = 0; attempt < 500; attempt++) {
+		HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+		if (snapshot == INVALID_HANDLE_VALUE)
+			return false;
+
+		PROCESSENTRY32W entry;
+		entry.dwSize = sizeof(entry);
+		bool running = false;
+		if (Process32FirstW(snapshot, &entry)) {
+			do {
+				running = running ||
+					  _wcsicmp(entry.szExeFile,
+						   L"procedure-idle.exe") == 0;
+			} while (Process32NextW(snapshot, &entry));
+		}
+		CloseHandle(snapshot);
+		if (!running)
+			return true;
+		Sleep(10);
+	}
+	return false;
+}
+
+static std::string ConfigJson()
+{
+	std::string directory = PluginHost::Directory();
+	std::replace(directory.begin(), directory.end(), '\\', '/');
+	return "{\"enabled\": false, \"askToLaunch\": false, \"loadouts\": [{"
+	       "\"name\": \"procedure-test\", \"programs\": [{\"path\": \"" +
+	       directory + "\", \"executable\": \"" + IdleProgram +
+	       "\", \"arguments\": \"--idle\"}]}]}";
+}
+
+static bool Call(proc_handler_t *procs, const char *name, calldata_t *cd,
+		 double &totalMs)
+{
+	uint64_t start = os_gettime_ns();
+	bool found = proc_handler_call(procs, name, cd);
+	totalMs += (double)(os_gettime_ns() - start) / 1000000.0;
+	return found && calldata_bool(cd, "success");
+}
+
+int main(int argc, char *argv[])
+{
+	// Launched by the test itself, quit by the plugin
+	if (argc == 2 && strcmp(argv[1], "--idle") == 0) {
+		Sleep(60000);
+		return 0;
+	}
+
+	// The plugin creates widgets, they are never shown
+	QApplication app(argc, argv);
+
+	if (!PluginHost::Start())
+		return 1;
+	if (!PluginHost::WriteConfig(ConfigJson().c_str()) ||
+	    !PluginHost::Load()) {
+		fprintf(stderr, "obs_module_load failed\n");
+		PluginHost::Stop();
+		return 1;
+	}
+
+	proc_handler_t *procs = obs_get_proc_handler();
+	calldata_t cd;
+	calldata_init(&cd);
+	calldata_set_string(&cd, "loadout", "procedure-test");
+
+	// The first call is not timed, it only checks the procedure exists
+	bool found = proc_handler_call(procs, "autostarter_status", &cd);
+	bool idle = found && !calldata_bool(&cd, "launched") &&
+		    calldata_int(&cd, "running") == 0;
+
+	uint64_t start = os_gettime_ns();
+	for (int i = 0; i < StatusCalls; i++)
+		proc_handler_call(procs, "autostarter_status", &cd);
+	double statusUs =
+		(double)(os_gettime_ns() - start) / 1000.0 / StatusCalls;
+
+	double launchMs = 0.0;
+	double quitMs = 0.0;
+	int failures = 0;
+	for (int i = 0; i < LaunchCalls; i++) {
+		if (!Call(procs, "autostarter_launch", &cd, launchMs))
+			failures++;
+		proc_handler_call(procs, "autostarter_status", &cd);
+		if (calldata_int(&cd, "running") != 1)
+			failures++;
+		if (!Call(procs, "autostarter_quit", &cd, quitMs))
+			failures++;
+		if (!WaitForIdleExit())
+			failures++;
+	}
+
+	calldata_free(&cd);
+	PluginHost::Stop();
+
+	printf("autostarter_status: %.3f us per call over %d calls (budget %.1f us)\n",
+	       statusUs, StatusCalls, Constants::PROCEDURE_CALL_BUDGET_US);
+	printf("autostarter_launch: %.3f ms, autostarter_quit: %.3f ms per call over %d calls\n",
+	       launchMs / LaunchCalls, quitMs / LaunchCalls, LaunchCalls);
+
+	if (!found) {
+		fprintf(stderr, "autostarter_status is not registered\n");
+		return 1;
+	}
+	if (!idle) {
+		fprintf(stderr, "autostarter_status reports an idle loadout as launched\n");
+		return 1;
+	}
+	if (failures > 0) {
+		fprintf(stderr, "%d launch or quit calls failed\n", failures);
+		return 1;
+	}
+	if (statusUs > Constants::PROCEDURE_CALL_BUDGET_US) {
+		fprintf(stderr, "Procedure calls are over budget\n");
+		return 1;
+	}
+	return 0;
+}